@@ -0,0 +1,79 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ *  衝突規則の呼び分け (ObjectBase::collide) にかかる時間を測る．
+ *
+ *  Droplet と Racket の組には規則が登録されていないので，collide は表を引くだけで
+ * 戻る．呼び分け以外の処理を含まない時間を 1 組あたりで表示する．
+ *
+ *  使い方: bench-dispatch [ステージ設定ファイル [呼び出し回数]]
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <glibmm.h>
+#include "object-manager.hpp"
+#include "object-droplet.hpp"
+#include "object-racket.hpp"
+
+int
+main (int    argc,
+      char * argv[])
+{
+    using DropletCollection::Object::Manager;
+    using DropletCollection::Object::Droplet;
+    using DropletCollection::Object::Racket;
+
+    const std::string filename = (argc > 1) ? std::string(argv[1])
+                                            : Glib::build_filename(DC_DATADIR, "stage/stage001");
+    const long        n_calls  = (argc > 2) ? std::atol(argv[2]) : 20000000L;
+    long              i, n_hits = 0;
+
+    if( ! Glib::thread_supported() ) Glib::thread_init();
+
+    try
+    {
+        Manager  manager(filename);
+        manager.initialize();
+
+        Droplet *droplet = manager.attach<Droplet>();
+        Racket  *racket  = manager.attach<Racket>();
+
+        Glib::Timer timer;
+        timer.start();
+        for( i = 0; i < n_calls; ++i )
+        {
+            if( droplet->collide(*racket) ) ++n_hits;
+        }
+        timer.stop();
+
+        std::printf("collide (Droplet x Racket): %.2f ns/pair (%ld calls, %ld hits)\n",
+                    timer.elapsed() / n_calls * 1.0e9, n_calls, n_hits);
+    }
+    catch(Glib::Error& e)
+    {
+        std::fprintf(stderr, "%s: %s\n", filename.c_str(), e.what().c_str());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
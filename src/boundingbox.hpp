@@ -0,0 +1,120 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_79161698_F1C9_4B00_ABCA_AF0864958A42
+#define INCLUDE_GUARD_79161698_F1C9_4B00_ABCA_AF0864958A42
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include "vector.hpp"
+
+namespace DropletCollection
+{
+    /**
+     * @brief 座標軸に平行な矩形 (AABB)
+     */
+    struct BoundingBox
+    {
+        double left;
+        double top;
+        double right;
+        double bottom;
+
+        BoundingBox ()
+            : left(0.0), top(0.0), right(0.0), bottom(0.0)
+        {
+        }
+
+        BoundingBox (double l, double t, double r, double b)
+            : left(l), top(t), right(r), bottom(b)
+        {
+        }
+
+        BoundingBox (const Vector<double>& center, double radius)
+            : left(center.get_x() - radius), top(center.get_y() - radius),
+              right(center.get_x() + radius), bottom(center.get_y() + radius)
+        {
+        }
+
+        inline double get_width  () const { return right - left; }
+        inline double get_height () const { return bottom - top; }
+
+        inline bool
+        operator == (const BoundingBox& other) const
+        {
+            return left == other.left && top == other.top &&
+                   right == other.right && bottom == other.bottom;
+        }
+
+        inline bool
+        operator != (const BoundingBox& other) const
+        {
+            return ! (*this == other);
+        }
+
+        /**
+         * @brief 2つの矩形が重なっている (辺が接している場合を含む) かどうか
+         */
+        inline bool
+        intersects (const BoundingBox& other) const
+        {
+            return left <= other.right && other.left <= right &&
+                   top <= other.bottom && other.top <= bottom;
+        }
+
+        /**
+         * @brief 2つの矩形の間の距離 (座標軸ごとの隙間のうち最大のもの)
+         *
+         *  重なっていれば 0 以下となる．@c margin だけ広げた矩形と重なるのは，距離が
+         * @c margin 以下のときである．
+         */
+        inline double
+        get_gap (const BoundingBox& other) const
+        {
+            return std::max(std::max(other.left - right, left - other.right),
+                            std::max(other.top - bottom, top - other.bottom));
+        }
+
+        /**
+         * @brief 矩形を上下左右に @c margin だけ広げる
+         */
+        inline BoundingBox&
+        expand (double margin)
+        {
+            left -= margin; top -= margin; right += margin; bottom += margin;
+            return *this;
+        }
+
+        /**
+         * @brief 矩形を @c other も含む最小の矩形に広げる
+         */
+        inline BoundingBox&
+        merge (const BoundingBox& other)
+        {
+            if( other.left   < left   ) left   = other.left;
+            if( other.top    < top    ) top    = other.top;
+            if( other.right  > right  ) right  = other.right;
+            if( other.bottom > bottom ) bottom = other.bottom;
+            return *this;
+        }
+    };
+}
+
+#endif /* ! INCLUDE_GUARD_79161698_F1C9_4B00_ABCA_AF0864958A42 */
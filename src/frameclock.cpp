@@ -0,0 +1,144 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include "error.hpp"
+#include "frameclock.hpp"
+
+namespace DropletCollection
+{
+    FrameClock::FrameClock (const double       tick_interval,
+                            const unsigned int max_ticks)
+        : m_tick_interval(tick_interval),
+          m_max_ticks(max_ticks),
+          m_last_time(0.0),
+          m_accumulator(0.0),
+          m_report_time(0.0)
+    {
+        dc_warn_if_fail(tick_interval > 0.0);
+        dc_warn_if_fail(max_ticks > 0);
+
+        restart(0.0);
+    }
+
+    /**
+     * @brief 蓄積した経過時間と実行状況を捨て，時刻 @c now から数え直す
+     *
+     *  ステージの読み込みなど，シミュレーションを止めていた時間を取り戻さないために使う．
+     */
+    void
+    FrameClock::restart (const double now)
+    {
+        m_last_time   = now;
+        m_accumulator = 0.0;
+        m_report_time = now;
+
+        m_report.duration  = 0.0;
+        m_report.n_ticks   = 0;
+        m_report.n_frames  = 0;
+        m_report.n_extra   = 0;
+        m_report.n_dropped = 0;
+    }
+
+    /**
+     * @brief 時刻 @c now までの経過時間を蓄積し，いま進めるべき tick 数を返す
+     *
+     *  返す tick 数は 0 以上 m_max_ticks 以下である．上限を超えた分の経過時間は捨て，
+     * 捨てた tick 数として数える (シミュレーションが実時間より遅れることを許す)．
+     */
+    unsigned int
+    FrameClock::advance (const double now)
+    {
+        unsigned int n = 0;
+
+        if( now > m_last_time ) m_accumulator += now - m_last_time;
+        m_last_time = now;
+
+        while( m_accumulator >= m_tick_interval && n < m_max_ticks )
+        {
+            m_accumulator -= m_tick_interval;
+            ++n;
+        }
+
+        if( m_accumulator >= m_tick_interval ) // 追いつけない分は捨てる
+        {
+            const unsigned int dropped = static_cast<unsigned int>(m_accumulator / m_tick_interval);
+
+            m_accumulator     -= dropped * m_tick_interval;
+            m_report.n_dropped += dropped;
+        }
+
+        m_report.n_ticks += n;
+        if( n > 1 ) m_report.n_extra += n - 1;
+
+        return n;
+    }
+
+    /**
+     * @brief 時刻 @c now に，最後の tick から経過した時間の 1 tick に対する割合 (0 以上 1 以下) を返す
+     *
+     *  描画時に前の tick と現在の tick の状態を補間するのに使う．描画は advance() と
+     * 別に行うので，最後の advance() から @c now までの時間も含める．次の tick が遅れて
+     * いる間は 1 (現在の tick の状態) に留める．
+     */
+    double
+    FrameClock::get_alpha (const double now) const
+    {
+        double elapsed = m_accumulator;
+
+        if( now > m_last_time ) elapsed += now - m_last_time;
+
+        return std::min(elapsed / m_tick_interval, 1.0);
+    }
+
+    /**
+     * @brief 描画した回数を数える
+     */
+    void
+    FrameClock::count_frame ()
+    {
+        ++m_report.n_frames;
+    }
+
+    /**
+     * @brief 前回から @c interval 秒以上経っていれば，その間の実行状況を @c report に格納して数え直す
+     *
+     * @return 実行状況を格納したら true を返す．
+     */
+    bool
+    FrameClock::take_report (const double now,
+                             const double interval,
+                             Report&      report)
+    {
+        if( now - m_report_time < interval ) return false;
+
+        report          = m_report;
+        report.duration = now - m_report_time;
+
+        m_report_time      = now;
+        m_report.n_ticks   = 0;
+        m_report.n_frames  = 0;
+        m_report.n_extra   = 0;
+        m_report.n_dropped = 0;
+
+        return true;
+    }
+}
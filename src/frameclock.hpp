@@ -0,0 +1,78 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_CA5AD91D_D407_4358_B010_ED85CEEC43C3
+#define INCLUDE_GUARD_CA5AD91D_D407_4358_B010_ED85CEEC43C3
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+namespace DropletCollection
+{
+    /**
+     * @brief 実時間に合わせて，描画 1 回ごとに進めるべきシミュレーションの tick 数を決める
+     *
+     *  advance() へ単調増加する時刻を渡すと，前回からの経過時間を蓄積し，1 tick の長さに
+     * 達した分だけの tick 数を返す．処理が滞ったときに tick が溜まり続けないよう，1 回に返す
+     * tick 数には上限があり，それを超えた分は捨てる．描画は tick とは別の間隔で行い，
+     * get_alpha() で描画時刻の tick の間の位置を求める．
+     */
+    class FrameClock
+    {
+        public:
+            // 前回の take_report() からの実行状況
+            struct Report
+            {
+                double       duration;  //< 集計した期間 [s]
+                unsigned int n_ticks;   //< 進めた tick 数
+                unsigned int n_frames;  //< 描画した回数
+                unsigned int n_extra;   //< 1 回の advance() で 2 tick 以上進めたときの，2 tick 目以降の数
+                unsigned int n_dropped; //< 上限を超えたために捨てた tick 数
+            };
+
+            FrameClock (double       tick_interval,
+                        unsigned int max_ticks);
+
+            void                 restart           (double now);
+            unsigned int         advance           (double now);
+            void                 count_frame       ();
+            bool                 take_report       (double  now,
+                                                    double  interval,
+                                                    Report& report);
+            inline double        get_tick_interval () const;
+            double               get_alpha         (double now) const;
+
+        private:
+            double       m_tick_interval; //< 1 tick の長さ [s]
+            unsigned int m_max_ticks;     //< 1 回の advance() で返す tick 数の上限
+            double       m_last_time;     //< 前回の advance() の時刻
+            double       m_accumulator;   //< まだ tick に変換していない経過時間 [s]
+
+            // take_report() で返す実行状況
+            double       m_report_time;
+            Report       m_report;
+    };
+
+    inline double
+    FrameClock::get_tick_interval () const
+    {
+        return m_tick_interval;
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_CA5AD91D_D407_4358_B010_ED85CEEC43C3 */
@@ -19,9 +19,15 @@
 #  include "config.h"
 #endif
 
+#include <algorithm>
 #include <gtkmm.h>
 #include "error.hpp"
+#include "frameclock.hpp"
 #include "object-manager.hpp"
+#include "object-objectbase.hpp"
+#include "object-circlekernel.hpp"
+#include "object-circlestore.hpp"
+#include "object-forcegrid.hpp"
 
 namespace DropletCollection
 {
@@ -34,21 +40,44 @@ namespace DropletCollection
             void unload ();
             void reset  ();
 
+            static bool set_tick_rate  (double rate);
+            static bool set_frame_rate (double rate);
+
         protected:
             virtual bool on_motion_notify_event (GdkEventMotion * event);
             virtual bool on_button_press_event  (GdkEventButton * event);
             virtual bool on_expose_event        (GdkEventExpose * event);
-            virtual bool on_timeout             ();
+            virtual bool on_tick                ();
+            virtual bool on_frame               ();
 
         private:
+            static unsigned int get_max_ticks          ();
+            static unsigned int get_tick_poll_interval ();
+
+            static double             m_tick_interval;   //< シミュレーション 1 tick の長さ [s]
+            static const double       m_max_catch_up;    //< 1 回の on_tick() で進めるシミュレーション時間の上限 [s]
+            static unsigned int       m_frame_interval;  //< 描画の間隔 [ms]
+            static const double       m_report_interval; //< 実行状況を表示する間隔 [s]
+
             DropletCollection::Object::Manager * m_manager; // 現在プレイ中のステージ
+            Glib::Timer                          m_timer; // 単調増加する実時間
+            FrameClock                           m_clock; // 実時間に合わせて進める tick 数を決める
     };
 
+    double             Screen::m_tick_interval   = Object::ObjectBase::get_reference_time_step();
+    const double       Screen::m_max_catch_up    = 0.175;
+    unsigned int       Screen::m_frame_interval  = 16; // 約 60 fps
+    const double       Screen::m_report_interval = 10.0;
+
     Screen::Screen ()
-        : m_manager(0)
+        : m_manager(0),
+          m_clock(m_tick_interval, get_max_ticks())
     {
         add_events(Gdk::POINTER_MOTION_MASK | Gdk::BUTTON_PRESS_MASK);
-        Glib::signal_timeout().connect(sigc::mem_fun(*this, &Screen::on_timeout), 35);
+
+        // シミュレーションの tick と画面の描画は別のタイマーで行う (tick の間は補間して描く)
+        Glib::signal_timeout().connect(sigc::mem_fun(*this, &Screen::on_tick), get_tick_poll_interval());
+        Glib::signal_timeout().connect(sigc::mem_fun(*this, &Screen::on_frame), m_frame_interval);
     }
 
     void
@@ -62,6 +91,7 @@ namespace DropletCollection
 
         set_size_request(m_manager->get_width(), m_manager->get_height());
 
+        m_clock.restart(m_timer.elapsed()); // 読み込みにかかった時間は取り戻さない
         queue_draw(); // 画面を再描画する
     }
 
@@ -79,6 +109,7 @@ namespace DropletCollection
         if( m_manager == 0 ) return;
 
         m_manager->initialize();
+        m_clock.restart(m_timer.elapsed());
         queue_draw(); // 画面を再描画する
     }
 
@@ -113,17 +144,97 @@ namespace DropletCollection
     {
         if( m_manager == 0 ) return false;
 
-        m_manager->draw( get_window()->create_cairo_context() ); // 画面を描画する
+        m_manager->synchronize(); // 待機している物体 (ENGINE_EVENT) も現在の tick まで進めておく
+        m_manager->draw( get_window()->create_cairo_context(), m_clock.get_alpha(m_timer.elapsed()) ); // tick の間を補間して画面を描画する
+        m_clock.count_frame();
+
+        return true;
+    }
+
+    /**
+     * @brief シミュレーションの tick レート [Hz] を設定する (Screen を作る前に呼び出す)
+     *
+     *  物理定数は秒あたりの値で扱っているので，tick レートを変えてもゲームの速さは
+     * 変わらない (細かくすると精度が上がり，粗くすると計算量が減る)．
+     */
+    bool
+    Screen::set_tick_rate (const double rate)
+    {
+        dc_return_val_if_fail(rate >= 1.0 && rate <= 1000.0, false);
 
+        m_tick_interval = 1.0 / rate;
         return true;
     }
 
+    /**
+     * @brief 画面の描画レート [Hz] を設定する (Screen を作る前に呼び出す)
+     *
+     *  tick レートとは独立なので，シミュレーションの計算量を変えずに高いリフレッシュレートの
+     * 画面へ合わせられる．描画の間隔は 1 ms 単位に丸める．
+     */
     bool
-    Screen::on_timeout ()
+    Screen::set_frame_rate (const double rate)
+    {
+        dc_return_val_if_fail(rate >= 1.0 && rate <= 1000.0, false);
+
+        m_frame_interval = std::max(1u, static_cast<unsigned int>(1000.0 / rate + 0.5));
+        return true;
+    }
+
+    /**
+     * @brief 1 回の on_tick() で進める tick 数の上限 (m_max_catch_up 秒に相当する数) を返す
+     */
+    unsigned int
+    Screen::get_max_ticks ()
     {
+        return std::max(1u, static_cast<unsigned int>(m_max_catch_up / m_tick_interval + 0.5));
+    }
+
+    /**
+     * @brief on_tick() を呼び出す間隔 [ms] を返す (1 tick の長さ以下)
+     */
+    unsigned int
+    Screen::get_tick_poll_interval ()
+    {
+        return std::max(1u, static_cast<unsigned int>(m_tick_interval * 1000.0));
+    }
+
+    /**
+     * @brief 定期的に呼び出され，経過した実時間の分だけシミュレーションを進める
+     *
+     *  シミュレーションは常に m_tick_interval 秒ずつ進めるので，呼び出しの間隔が乱れても
+     * ゲームの速さは変わらない．処理が大きく遅れたときは，m_max_catch_up 秒を超えた分の
+     * tick を捨てる (ゲームが一時的に遅くなる)．画面の描画は on_frame() で別に行う．
+     */
+    bool
+    Screen::on_tick ()
+    {
+        const double now = m_timer.elapsed();
+        FrameClock::Report report;
+
         if( m_manager == 0 ) return true;
 
-        m_manager->simulate(); // 物体の動きをシミュレーションする
+        m_manager->fast_forward(m_clock.get_tick_interval(), m_clock.advance(now)); // 物体の動きをシミュレーションする
+
+        if( m_clock.take_report(now, m_report_interval, report) )
+        {
+            dc_log("tick %.1f Hz, 描画 %.1f fps, 追加 tick %u, 破棄 tick %u",
+                   report.n_ticks / report.duration, report.n_frames / report.duration,
+                   report.n_extra, report.n_dropped);
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief m_frame_interval ごとに呼び出され，画面を再描画する
+     *
+     *  tick の途中でも，描画する時刻に合わせて前後の tick の状態を補間する (on_expose_event())．
+     */
+    bool
+    Screen::on_frame ()
+    {
+        if( m_manager == 0 ) return true;
 
         queue_draw(); // 画面を再描画する
 
@@ -287,7 +398,94 @@ int
 main (int    argc,
       char * argv[])
 {
-    Gtk::Main kit(argc, argv);
+    using DropletCollection::Object::CircleKernel;
+    using DropletCollection::Object::CircleStore;
+    using DropletCollection::Object::ForceGrid;
+    using DropletCollection::Object::Manager;
+
+    Glib::OptionContext context;
+    Glib::OptionGroup   group("droplet-collection", "Droplet Collection のオプション");
+    Glib::OptionEntry   entry_kernel, entry_verify, entry_exact_forces, entry_no_sleep, entry_tick_rate;
+    Glib::OptionEntry   entry_no_sweep, entry_no_substep, entry_engine, entry_threads, entry_island;
+    Glib::OptionEntry   entry_frame_rate;
+    Glib::ustring       kernel_name, engine_name;
+    bool                verify_kernels = false;
+    bool                exact_forces = false;
+    bool                no_sleep = false;
+    double              tick_rate = 0.0;
+    double              frame_rate = 0.0;
+    bool                no_sweep = false;
+    bool                no_substep = false;
+    int                 n_threads = 0;
+    bool                island = false;
+
+    if( ! Glib::thread_supported() ) Glib::thread_init();
+
+    entry_kernel.set_long_name("kernel");
+    entry_kernel.set_arg_description("NAME");
+    entry_kernel.set_description("物体の移動に使う計算カーネル (scalar, sse2, avx2)");
+    group.add_entry(entry_kernel, kernel_name);
+
+    entry_verify.set_long_name("verify-kernels");
+    entry_verify.set_description("計算カーネルの結果をスカラー版と比較する");
+    group.add_entry(entry_verify, verify_kernels);
+
+    entry_exact_forces.set_long_name("exact-force-fields");
+    entry_exact_forces.set_description("ForceField の力を格子にまとめず，ForceField ごとに計算する");
+    group.add_entry(entry_exact_forces, exact_forces);
+
+    entry_no_sleep.set_long_name("no-sleep");
+    entry_no_sleep.set_description("静止した Droplet を休眠させず，常に衝突計算を行う");
+    group.add_entry(entry_no_sleep, no_sleep);
+
+    entry_tick_rate.set_long_name("tick-rate");
+    entry_tick_rate.set_arg_description("HZ");
+    entry_tick_rate.set_description("シミュレーションの tick レート (既定は約 28.6 Hz)");
+    group.add_entry(entry_tick_rate, tick_rate);
+
+    entry_frame_rate.set_long_name("frame-rate");
+    entry_frame_rate.set_arg_description("HZ");
+    entry_frame_rate.set_description("画面の描画レート (既定は約 60 Hz; tick レートとは独立)");
+    group.add_entry(entry_frame_rate, frame_rate);
+
+    entry_no_sweep.set_long_name("no-sweep");
+    entry_no_sweep.set_description("Ball の連続衝突判定を行わず，tick の終わりの位置だけで衝突を判定する");
+    group.add_entry(entry_no_sweep, no_sweep);
+
+    entry_no_substep.set_long_name("no-substep");
+    entry_no_substep.set_description("高速な物体も 1 tick に 1 回だけ移動させ，衝突を判定する");
+    group.add_entry(entry_no_substep, no_substep);
+
+    entry_engine.set_long_name("engine");
+    entry_engine.set_arg_description("NAME");
+    entry_engine.set_description("移動と衝突判定の方式 (tick, event; 既定はステージの設定に従う)");
+    group.add_entry(entry_engine, engine_name);
+
+    entry_threads.set_long_name("threads");
+    entry_threads.set_arg_description("N");
+    entry_threads.set_description("衝突の検出と計算に使うスレッド数 (既定は 1; 結果はスレッド数によらない)");
+    group.add_entry(entry_threads, n_threads);
+
+    entry_island.set_long_name("island");
+    entry_island.set_description("movable 物体同士の衝突を島ごとに分担して計算する (結果は添字の順に計算する場合と異なり得る)");
+    group.add_entry(entry_island, island);
+
+    context.set_main_group(group);
+
+    Gtk::Main kit(argc, argv, context);
+
+    if( ! kernel_name.empty() ) CircleKernel::set_level(kernel_name);
+    CircleKernel::set_verify(verify_kernels);
+    ForceGrid::set_exact(exact_forces);
+    CircleStore::set_sleep_enabled(! no_sleep);
+    if( tick_rate != 0.0 ) DropletCollection::Screen::set_tick_rate(tick_rate);
+    if( frame_rate != 0.0 ) DropletCollection::Screen::set_frame_rate(frame_rate);
+    Manager::set_sweep_enabled(! no_sweep);
+    Manager::set_substep_enabled(! no_substep);
+    if( ! engine_name.empty() ) Manager::set_engine(engine_name);
+    if( n_threads > 0 ) Manager::set_n_threads(n_threads);
+    Manager::set_island_enabled(island);
+
     DropletCollection::MainWindow window;
 
     window.show_all();
@@ -0,0 +1,167 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include "error.hpp"
+#include "object-aabbtree.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        namespace
+        {
+            // 要素を矩形の中心座標で比較する
+            template <class ItemT>
+            struct CompareCenter
+            {
+                bool vertical;
+
+                explicit CompareCenter (bool v) : vertical(v) {}
+
+                bool operator () (const ItemT& lhs, const ItemT& rhs) const
+                {
+                    if( vertical ) return lhs.box.top + lhs.box.bottom < rhs.box.top + rhs.box.bottom;
+                    else           return lhs.box.left + lhs.box.right < rhs.box.left + rhs.box.right;
+                }
+            };
+        }
+
+        AABBTree::AABBTree ()
+        {
+        }
+
+        void
+        AABBTree::clear ()
+        {
+            m_items.clear();
+            m_nodes.clear();
+        }
+
+        /**
+         * @brief 要素を追加する (build() を呼び出すまで問い合わせには反映されない)
+         */
+        void
+        AABBTree::insert (const std::size_t  index,
+                          const BoundingBox& box)
+        {
+            Item item = {index, box};
+            m_items.push_back(item);
+        }
+
+        void
+        AABBTree::build ()
+        {
+            m_nodes.clear();
+            if( m_items.empty() ) return;
+
+            m_nodes.reserve(2 * m_items.size());
+            build_node(0, m_items.size());
+
+            dc_log("AABBTree: 要素数 %lu, 節点数 %lu",
+                   (unsigned long) m_items.size(), (unsigned long) m_nodes.size());
+        }
+
+        /**
+         * @brief m_items[first, first + count) を覆う部分木を構築し，その根の番号を返す
+         */
+        std::size_t
+        AABBTree::build_node (const std::size_t first,
+                              const std::size_t count)
+        {
+            const std::size_t id = m_nodes.size();
+            Node node;
+
+            node.box = m_items[first].box;
+            for( std::size_t i = first + 1; i < first + count; ++i ) node.box.merge(m_items[i].box);
+            node.first = first;
+            node.count = count;
+            node.right = 0;
+            m_nodes.push_back(node);
+
+            if( count > LEAF_SIZE )
+            {
+                // 長い方の軸について，中心座標の中央値で二分割する
+                const bool vertical = node.box.get_height() > node.box.get_width();
+                const std::size_t half = count / 2;
+
+                std::nth_element(m_items.begin() + first,
+                                 m_items.begin() + first + half,
+                                 m_items.begin() + first + count,
+                                 CompareCenter<Item>(vertical));
+
+                m_nodes[id].count = 0;
+                build_node(first, half); // 左の子は id + 1 に置かれる
+                const std::size_t right = build_node(first + half, count - half);
+                m_nodes[id].right = right;
+            }
+
+            return id;
+        }
+
+        /**
+         * @brief 矩形 @c box と重なる要素の番号を @c result に追加する (順序は不定)
+         */
+        void
+        AABBTree::query (const BoundingBox&        box,
+                         std::vector<std::size_t>& result) const
+        {
+            query(box, result, m_stack);
+        }
+
+        /**
+         * @brief 作業領域に @c stack を使って query() を行う
+         *
+         *  作業領域を呼び出し側で用意すれば，複数のスレッドから同時に問い合わせてよい．
+         */
+        void
+        AABBTree::query (const BoundingBox&        box,
+                         std::vector<std::size_t>& result,
+                         std::vector<std::size_t>& stack) const
+        {
+            if( m_nodes.empty() ) return;
+
+            stack.clear();
+            stack.push_back(0);
+
+            while( ! stack.empty() )
+            {
+                const Node& node = m_nodes[stack.back()];
+                const std::size_t id = stack.back();
+                stack.pop_back();
+
+                if( ! node.box.intersects(box) ) continue;
+
+                if( node.count > 0 ) // 葉
+                {
+                    for( std::size_t i = node.first; i < node.first + node.count; ++i )
+                        if( m_items[i].box.intersects(box) )
+                            result.push_back(m_items[i].index);
+                }
+                else
+                {
+                    stack.push_back(node.right);
+                    stack.push_back(id + 1);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_E2E969F5_A52F_4477_8177_22D44C02CF66
+#define INCLUDE_GUARD_E2E969F5_A52F_4477_8177_22D44C02CF66
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <vector>
+#include "boundingbox.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        /**
+         * @brief 動かない物体のための静的な AABB 木
+         *
+         *  ステージの読み込み時に一度だけ構築し，以後は問い合わせのみを行う．
+         * 構築は重心の中央値で再帰的に二分割する．
+         */
+        class AABBTree
+        {
+            public:
+                AABBTree ();
+
+                void clear  ();
+                void insert (std::size_t        index,
+                             const BoundingBox& box);
+                void build  ();
+                void query  (const BoundingBox&        box,
+                             std::vector<std::size_t>& result) const;
+                void query  (const BoundingBox&        box,
+                             std::vector<std::size_t>& result,
+                             std::vector<std::size_t>& stack) const;
+
+            private:
+                struct Item
+                {
+                    std::size_t index;
+                    BoundingBox box;
+                };
+
+                struct Node
+                {
+                    BoundingBox box;
+                    std::size_t first; //< 葉に含まれる要素の m_items 上の先頭位置
+                    std::size_t count; //< 葉に含まれる要素数 (節なら 0)
+                    std::size_t right; //< 節の右の子の番号 (左の子は常に直後に置かれる)
+                };
+
+                enum { LEAF_SIZE = 2 };
+
+                std::size_t build_node (std::size_t first,
+                                        std::size_t count);
+
+                std::vector<Item>                m_items;
+                std::vector<Node>                m_nodes;
+                mutable std::vector<std::size_t> m_stack;
+        };
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_E2E969F5_A52F_4477_8177_22D44C02CF66 */
@@ -26,19 +26,26 @@ namespace DropletCollection
 {
     namespace Object
     {
-        const double       Ball::m_min_vy = 2.0; // 速度ベクトルのY成分の最小値 (必ずボールが手元に戻てくるために)
-        const unsigned int Ball::m_time_period = 20; // 速度調整周期
+        // 速度ベクトルのY成分の最小値 [px/s] (必ずボールが手元に戻てくるために)
+        const double Ball::m_min_vy = 2.0 / ObjectBase::get_reference_time_step();
+        // 速度調整周期 [s]
+        const double Ball::m_time_period = 20 * ObjectBase::get_reference_time_step();
 
         Ball::Ball (Manager& manager)
             : Globule(manager),
-              m_time_count(0),
+              m_time_count(0.0),
               m_speed(0.0),
+              m_carry_time(0.0),
               m_image(0)
         {
+            set_advanceable(true); // 速度の大きさを定期的に修正する
+            set_sleepable(false); // 発射前は静止しているが，休眠させない
+
             if( register_class("Ball") )
             {
                 register_function("Globule",
-                                  (CollideFunc) &Ball::collide_with_globule);
+                                  (DetectFunc) &Circle::detect_circle,
+                                  (RespondFunc) &Ball::collide_with_globule);
             }
         }
 
@@ -61,8 +68,8 @@ namespace DropletCollection
             set_radius((m_image->get_width() + m_image->get_height()) / 4.0);
             set_weight();
 
-            // 速度の取得
-            m_speed = file.get_double(get_name(), "Speed", 0, 65535);
+            // 速度の取得 (1 tick あたりの値を秒あたりに換算する)
+            m_speed = file.get_double(get_name(), "Speed", 0, 65535) / get_reference_time_step();
             // 質量の取得
             if( file.has_key(get_name(), "Weight") )
             {
@@ -71,70 +78,78 @@ namespace DropletCollection
         }
 
         void
-        Ball::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        Ball::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                    const double                         alpha) const
         {
             dc_return_if_fail(cr != 0);
             dc_return_if_fail(m_image != 0);
 
+            const Vector<double> p = get_draw_position(alpha);
+
             Gdk::Cairo::set_source_pixbuf(cr, m_image,
-                                          get_position().get_x() - get_radius(),
-                                          get_position().get_y() - get_radius());
+                                          p.get_x() - get_radius(),
+                                          p.get_y() - get_radius());
             cr->paint();
         }
 
         void
-        Ball::advance ()
+        Ball::advance (const double dt)
         {
-            if( ++m_time_count == m_time_period ) // 速度ベクトルの大きさを定期的に修正する
+            // 速度ベクトルの大きさを定期的に修正する
+            // (経過時間の丸め誤差で 1 tick 遅れないよう，周期に最も近い tick で修正する)
+            m_time_count += dt;
+            if( m_time_count + 0.5 * dt >= m_time_period )
             {
                 if( ! get_velocity().is_zero() ) set_velocity(get_velocity().set_size(m_speed));
-                m_time_count = 0;
+                m_time_count = 0.0;
             }
 
-            Globule::advance();
+            Globule::advance(dt);
         }
 
+        /**
+         * @brief Ball と Globule の衝突に応答する (接触は Circle::detect_circle() で検出する)
+         */
         bool
-        Ball::collide_with_globule (Ball&    self,
-                                    Globule& other)
+        Ball::collide_with_globule (Ball&           self,
+                                    Globule&        other,
+                                    const Manifold& manifold)
         {
-            const double distance = self.get_distance(other);
+            const Vector<double>& norm = manifold.normal;
+            const double distance = manifold.distance;
+            Vector<double> va, vb;
+
+            decompose_velocity(self, other, norm, va, vb);
+            self.record_contact(other, -norm, distance);
+
+            if( !self.is_collided(other) ) // まだ衝突してないなら，非弾性衝突をする
+            {
+                inelastic_collision(self, other, va, vb);
+                va = norm.nob_decompose(self.get_velocity());
+                va.set_x(-va.get_x());
+            }
+            else // 食い込み修正用の擬似衝突規則
+            {
+                const double rate = 1.0 / get_reference_time_step(); // 食い込みを 1 基準 tick で解消する
+                if( fiszero(va.get_x()) ) va.set_x(distance * rate * self.get_restitution());
+                if( fiszero(vb.get_x()) ) vb.set_x(-distance * rate * other.get_restitution());
+            }
 
-            if( fge(distance, 0.0) )
+            self.set_velocity(norm.nob_compose(va));
+            other.set_velocity(norm.nob_compose(vb));
+
+            // 速度ベクトルの Y 成分の値を調整する
+            Vector<double> new_v = self.get_velocity();
+            if( std::fabs(new_v.get_y()) < m_min_vy ) // 衝突後の Y 座標変化が少なすぎる
             {
-                Vector<double> norm, va, vb;
-                decompose_velocity(self, other, norm, va, vb);
-
-                if( !self.is_collided(other) ) // まだ衝突してないなら，非弾性衝突をする
-                {
-                    inelastic_collision(self, other, va, vb);
-                    va = norm.nob_decompose(self.get_velocity());
-                    va.set_x(-va.get_x());
-                }
-                else // 食い込み修正用の擬似衝突規則
-                {
-                    if( fiszero(va.get_x()) ) va.set_x(distance * self.get_restitution());
-                    if( fiszero(vb.get_x()) ) vb.set_x(-distance * other.get_restitution());
-                }
-
-                self.set_velocity(norm.nob_compose(va));
-                other.set_velocity(norm.nob_compose(vb));
-
-                // 速度ベクトルの Y 成分の値を調整する
-                Vector<double> new_v = self.get_velocity();
-                if( std::fabs(new_v.get_y()) < m_min_vy ) // 衝突後の Y 座標変化が少なすぎる
-                {
-                    if( new_v.get_y() > 0.0 ) new_v.set_y(m_min_vy);
-                    else                      new_v.set_y(-m_min_vy);
-                    self.set_velocity(new_v);
-
-                    dc_log("Ball の Y 座標変化量を増加させました");
-                }
-
-                return true;
+                if( new_v.get_y() > 0.0 ) new_v.set_y(m_min_vy);
+                else                      new_v.set_y(-m_min_vy);
+                self.set_velocity(new_v);
+
+                dc_log("Ball の Y 座標変化量を増加させました");
             }
 
-            return false;
+            return true;
         }
     }
 }
@@ -38,21 +38,26 @@ namespace DropletCollection
 
                 inline double                    get_speed            () const;
                 inline void                      set_speed            (double speed);
+                inline double                    get_carry_time       () const;
+                inline void                      set_carry_time       (double time);
                 inline Glib::RefPtr<Gdk::Pixbuf> get_image            () const;
                 inline void                      set_image            (const Glib::RefPtr<Gdk::Pixbuf>& image);
                 void                             launch               ();
                 virtual void                     load                 (const SettingFile& file);
-                virtual void                     draw                 (const Cairo::RefPtr<Cairo::Context>& cr) const;
-                virtual void                     advance              ();
-                static bool                      collide_with_globule (Ball&    self,
-                                                                       Globule& other);
+                virtual void                     draw                 (const Cairo::RefPtr<Cairo::Context>& cr,
+                                                                       double                               alpha) const;
+                virtual void                     advance              (double dt);
+                static bool                      collide_with_globule (Ball&           self,
+                                                                       Globule&        other,
+                                                                       const Manifold& manifold);
 
             private:
                 static const double       m_min_vy;
-                static const unsigned int m_time_period;
+                static const double       m_time_period;
 
-                unsigned int              m_time_count; //< 速度ベクトルの定期的修復に利用
-                double                    m_speed;
+                double                    m_time_count; //< 速度ベクトルの定期的修復に利用 [s]
+                double                    m_speed;      //< [px/s]
+                double                    m_carry_time; //< 連続衝突判定で次の tick へ繰り越した移動時間 [s]
                 Glib::RefPtr<Gdk::Pixbuf> m_image;
         };
 
@@ -68,6 +73,21 @@ namespace DropletCollection
             m_speed = speed;
         }
 
+        inline double
+        Ball::get_carry_time () const
+        {
+            return m_carry_time;
+        }
+
+        /**
+         * @brief 衝突した時刻で止めたために進めなかった時間を設定する (次の tick で進める)
+         */
+        inline void
+        Ball::set_carry_time (const double time)
+        {
+            m_carry_time = time;
+        }
+
         inline Glib::RefPtr<Gdk::Pixbuf>
         Ball::get_image () const
         {
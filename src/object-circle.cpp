@@ -19,8 +19,11 @@
 #  include "config.h"
 #endif
 
+#include <cmath>
 #include "error.hpp"
+#include "object-manager.hpp"
 #include "object-circle.hpp"
+#include "object-globule.hpp"
 
 namespace DropletCollection
 {
@@ -29,8 +32,8 @@ namespace DropletCollection
         Circle::Circle (Manager& manager,
                         bool     movable)
             : ObjectBase(manager, movable),
-              m_position(0.0, 0.0),
-              m_radius(0.0)
+              m_store(manager.get_circle_store()),
+              m_slot(m_store.allocate(*this))
         {
             register_class("Circle");
         }
@@ -38,35 +41,100 @@ namespace DropletCollection
         Circle::Circle (Manager&      manager,
                         const Circle& other)
             : ObjectBase(manager, other),
-              m_position(other.m_position),
-              m_radius(other.m_radius)
+              m_store(manager.get_circle_store()),
+              m_slot(m_store.allocate(*this))
         {
+            set_position(other.get_position());
+            set_radius(other.get_radius());
+        }
+
+        Circle::~Circle ()
+        {
+            m_store.release(m_slot);
         }
 
         void
         Circle::load (const SettingFile& file)
         {
-            m_position.set_x( file.get_double(get_name(), "X", 0, 65535) );
-            m_position.set_y( file.get_double(get_name(), "Y", 0, 65535) );
-            m_radius = file.get_double(get_name(), "Radius", 0, 65535);
+            set_position(Vector<double>(file.get_double(get_name(), "X", 0, 65535),
+                                        file.get_double(get_name(), "Y", 0, 65535)));
+            set_radius(file.get_double(get_name(), "Radius", 0, 65535));
+        }
+
+        bool
+        Circle::get_bounding_box (BoundingBox& box) const
+        {
+            box = BoundingBox(get_position(), get_radius());
+            return true;
+        }
+
+        /**
+         * @brief 移動する円 @c other が，この円と初めて接触する時刻を求める
+         *
+         *  この円は移動しないものとして，中心間の距離が半径の和に等しくなる時刻を求める．
+         */
+        bool
+        Circle::sweep (const Globule&        other,
+                       const Vector<double>& start,
+                       const Vector<double>& motion,
+                       double&               toi) const
+        {
+            const Vector<double> d = start - get_position();
+            const double r = get_radius() + other.get_radius();
+            const double a = Vector<double>::inner_product(motion, motion);
+            const double b = Vector<double>::inner_product(d, motion);
+            const double c = Vector<double>::inner_product(d, d) - r * r;
+
+            if( c <= 0.0 ) return false; // 既に接触している
+            if( b >= 0.0 ) return false; // 近づいていない
+
+            const double discriminant = b * b - a * c;
+            if( discriminant < 0.0 ) return false; // すれ違う
+
+            const double t = c / (-b + std::sqrt(discriminant)); // (-b - sqrt(D)) / a と等しく，桁落ちしない
+            if( t > 1.0 ) return false;
+
+            toi = t;
+            return true;
         }
 
         double
         Circle::get_distance (const Circle& other) const
         {
-            return m_radius + other.m_radius - m_position.distance(other.m_position);
+            return get_radius() + other.get_radius() - get_position().distance(other.get_position());
         }
 
         Vector<double>
         Circle::get_norm_to (const Circle& other) const
         {
-            return (other.m_position - m_position).get_unit();
+            return (other.get_position() - get_position()).get_unit();
         }
 
         Vector<double>
         Circle::get_norm_from (const Circle& other) const
         {
-            return (m_position - other.m_position).get_unit();
+            return (get_position() - other.get_position()).get_unit();
+        }
+
+        /**
+         * @brief 円同士の接触を検出する (円同士の衝突規則に共通の検出)
+         *
+         *  めり込みの深さと，@c other から @c self へ向かう法線を @c manifold に格納する．
+         */
+        bool
+        Circle::detect_circle (const Circle& self,
+                               const Circle& other,
+                               Manifold&     manifold)
+        {
+            const double distance = self.get_distance(other);
+
+            if( ! fge(distance, 0.0) ) return false;
+
+            manifold.normal   = self.get_norm_from(other);
+            manifold.distance = distance;
+            manifold.feature  = -1;
+
+            return true;
         }
     }
 }
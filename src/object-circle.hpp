@@ -24,6 +24,7 @@
 
 #include "vector.hpp"
 #include "object-objectbase.hpp"
+#include "object-circlestore.hpp"
 
 namespace DropletCollection
 {
@@ -36,45 +37,101 @@ namespace DropletCollection
                                  bool          movable);
                          Circle (Manager&      manager,
                                  const Circle& other);
+                virtual ~Circle ();
 
-                inline Vector<double> get_position () const;
-                inline void           set_position (const Vector<double>& pos);
-                inline double         get_radius   () const;
-                inline void           set_radius   (double radius);
-                virtual void          load         (const SettingFile& file);
+                inline Vector<double> get_position      () const;
+                inline void           set_position      (const Vector<double>& pos);
+                inline double         get_radius        () const;
+                inline void           set_radius        (double radius);
+                inline Vector<double> get_draw_position (double alpha) const;
+                inline double         get_draw_radius   (double alpha) const;
+                virtual void          load              (const SettingFile& file);
+                virtual bool          get_bounding_box  (BoundingBox& box) const;
+                virtual bool          sweep             (const Globule&        other,
+                                                         const Vector<double>& start,
+                                                         const Vector<double>& motion,
+                                                         double&               toi) const;
+
+                // For DropletCollection::Object::Manager
+                inline std::size_t get_slot () const;
 
             protected:
                 double         get_distance  (const Circle& other) const;
                 Vector<double> get_norm_to   (const Circle& other) const;
                 Vector<double> get_norm_from (const Circle& other) const;
+                static bool    detect_circle (const Circle& self,
+                                              const Circle& other,
+                                              Manifold&     manifold);
+
+                inline CircleStore& get_store () const;
 
             private:
-                Vector<double> m_position;
-                double         m_radius;
+                friend class CircleStore; // m_slot の更新
+
+                CircleStore& m_store; //< 位置・半径などの状態の格納先
+                std::size_t  m_slot;
         };
 
         inline Vector<double>
         Circle::get_position () const
         {
-            return m_position;
+            return Vector<double>(m_store.m_x[m_slot], m_store.m_y[m_slot]);
         }
 
         inline void
         Circle::set_position (const Vector<double>& pos)
         {
-            m_position = pos;
+            m_store.m_x[m_slot] = pos.get_x();
+            m_store.m_y[m_slot] = pos.get_y();
         }
 
         inline double
         Circle::get_radius () const
         {
-            return m_radius;
+            return m_store.m_radius[m_slot];
         }
 
         inline void
         Circle::set_radius (const double radius)
         {
-            m_radius = radius;
+            m_store.m_radius[m_slot] = radius;
+        }
+
+        /**
+         * @brief 前の tick から現在までを @c alpha (0 以上 1 以下) で補間した，描画する位置を返す
+         *
+         *  前の tick の状態を持たない円 (登録されたばかりの物体や fixed 物体) は現在の位置を返す．
+         */
+        inline Vector<double>
+        Circle::get_draw_position (const double alpha) const
+        {
+            if( ! m_store.m_prev_valid[m_slot] ) return get_position();
+
+            return Vector<double>(m_store.m_prev_x[m_slot] + (m_store.m_x[m_slot] - m_store.m_prev_x[m_slot]) * alpha,
+                                  m_store.m_prev_y[m_slot] + (m_store.m_y[m_slot] - m_store.m_prev_y[m_slot]) * alpha);
+        }
+
+        /**
+         * @brief 前の tick から現在までを @c alpha で補間した，描画する半径を返す
+         */
+        inline double
+        Circle::get_draw_radius (const double alpha) const
+        {
+            if( ! m_store.m_prev_valid[m_slot] ) return get_radius();
+
+            return m_store.m_prev_radius[m_slot] + (m_store.m_radius[m_slot] - m_store.m_prev_radius[m_slot]) * alpha;
+        }
+
+        inline CircleStore&
+        Circle::get_store () const
+        {
+            return m_store;
+        }
+
+        inline std::size_t
+        Circle::get_slot () const
+        {
+            return m_slot;
         }
     }
 }
@@ -0,0 +1,420 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "error.hpp"
+#include "object-circlekernel.hpp"
+
+// x86 の GCC 互換コンパイラでは，関数単位で命令セットを指定して SIMD 版を組み込む
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define DC_HAVE_X86_KERNELS 1
+#  include <immintrin.h>
+#endif
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        CircleKernel::Level CircleKernel::m_level        = CircleKernel::LEVEL_SCALAR;
+        bool                CircleKernel::m_level_inited = false;
+        bool                CircleKernel::m_verify       = false;
+
+        /**
+         * @brief 実行中の CPU で利用できる最も速い実装を返す
+         */
+        CircleKernel::Level
+        CircleKernel::get_supported_level ()
+        {
+#ifdef DC_HAVE_X86_KERNELS
+            __builtin_cpu_init();
+            if( __builtin_cpu_supports("avx2") ) return LEVEL_AVX2;
+            if( __builtin_cpu_supports("sse2") ) return LEVEL_SSE2;
+#endif
+            return LEVEL_SCALAR;
+        }
+
+        CircleKernel::Level
+        CircleKernel::get_level ()
+        {
+            if( ! m_level_inited )
+            {
+                m_level = get_supported_level();
+                m_level_inited = true;
+
+                dc_log("CircleKernel: '%s' を使用します", get_level_name(m_level));
+            }
+
+            return m_level;
+        }
+
+        /**
+         * @brief 使用する実装を指定する
+         *
+         * @return CPU が対応していなければ何もせずに false を返す．
+         */
+        bool
+        CircleKernel::set_level (const Level level)
+        {
+            dc_return_val_if_fail(level <= get_supported_level(), false);
+
+            m_level = level;
+            m_level_inited = true;
+
+            dc_log("CircleKernel: '%s' を使用します", get_level_name(m_level));
+
+            return true;
+        }
+
+        /**
+         * @brief 使用する実装を名前 ("scalar", "sse2", "avx2") で指定する
+         */
+        bool
+        CircleKernel::set_level (const std::string& name)
+        {
+            if( name == get_level_name(LEVEL_SCALAR) ) return set_level(LEVEL_SCALAR);
+            if( name == get_level_name(LEVEL_SSE2) )   return set_level(LEVEL_SSE2);
+            if( name == get_level_name(LEVEL_AVX2) )   return set_level(LEVEL_AVX2);
+
+            dc_warning("CircleKernel: '%s' という実装はありません", name.c_str());
+            return false;
+        }
+
+        const char *
+        CircleKernel::get_level_name (const Level level)
+        {
+            switch( level )
+            {
+                case LEVEL_SCALAR: return "scalar";
+                case LEVEL_SSE2:   return "sse2";
+                case LEVEL_AVX2:   return "avx2";
+            }
+
+            return "unknown";
+        }
+
+        bool
+        CircleKernel::get_verify ()
+        {
+            return m_verify;
+        }
+
+        void
+        CircleKernel::set_verify (const bool verify)
+        {
+            m_verify = verify;
+        }
+
+        /**
+         * @brief 粘性抵抗で速度を減衰させてから位置を時間刻み dt だけ進める
+         *
+         *  係数 k = visc_resist * radius * dt が 1.0 を超える場合は 1.0 に切り詰める．
+         * 減衰は exp(-visc_resist * radius * dt) の 1 次近似なので，時間刻みによって
+         * 減衰の速さがわずかに異なる (半径 30 px の Droplet で，基準の時間刻みと 1/240 秒とで 1.5% 程度)．
+         */
+        void
+        CircleKernel::integrate (const Arrays& arrays)
+        {
+            if( m_verify ) verify_integrate(arrays);
+            else           integrate_level(get_level(), arrays);
+        }
+
+        /**
+         * @brief 2 つの円の中心間の距離の 2 乗と半径の和の 2 乗を比べ，重なり得る円を求める
+         *
+         *  平方根を取らないので，衝突判定の前に大半の組を安価に除外できる．NaN を含む組は
+         * 重なり得るものとして扱う．
+         */
+        void
+        CircleKernel::overlap (const OverlapQuery& query)
+        {
+            if( m_verify ) verify_overlap(query);
+            else           overlap_level(get_level(), query);
+        }
+
+        void
+        CircleKernel::integrate_level (const Level   level,
+                                       const Arrays& arrays)
+        {
+            switch( level )
+            {
+                case LEVEL_AVX2: integrate_avx2(arrays);      break;
+                case LEVEL_SSE2: integrate_sse2(arrays);      break;
+                default:         integrate_scalar(arrays, 0); break;
+            }
+        }
+
+        void
+        CircleKernel::overlap_level (const Level         level,
+                                     const OverlapQuery& query)
+        {
+            switch( level )
+            {
+                case LEVEL_AVX2: overlap_avx2(query);      break;
+                case LEVEL_SSE2: overlap_sse2(query);      break;
+                default:         overlap_scalar(query, 0); break;
+            }
+        }
+
+        /**
+         * @brief 添字 @c first 以降をスカラー演算で処理する (SIMD 版の端数処理にも使う)
+         */
+        void
+        CircleKernel::integrate_scalar (const Arrays&     arrays,
+                                        const std::size_t first)
+        {
+            double       * const x      = arrays.x;
+            double       * const y      = arrays.y;
+            double       * const vx     = arrays.vx;
+            double       * const vy     = arrays.vy;
+            const double * const radius = arrays.radius;
+            const double * const visc   = arrays.visc_resist;
+            const double         dt     = arrays.dt;
+
+            for( std::size_t i = first; i < arrays.size; ++i )
+            {
+                const double k = std::min(visc[i] * radius[i] * dt, 1.0);
+
+                vx[i] = vx[i] - k * vx[i];
+                vy[i] = vy[i] - k * vy[i];
+                x[i]  = x[i] + vx[i] * dt;
+                y[i]  = y[i] + vy[i] * dt;
+            }
+        }
+
+        void
+        CircleKernel::overlap_scalar (const OverlapQuery& query,
+                                      const std::size_t   first)
+        {
+            for( std::size_t i = first; i < query.size; ++i )
+            {
+                const double dx = query.other_x[i] - query.x;
+                const double dy = query.other_y[i] - query.y;
+                const double r  = query.radius + query.other_radius[i];
+
+                query.hits[i] = ! (dx * dx + dy * dy > r * r);
+            }
+        }
+
+        // min(one, k) は k > 1.0 なら 1.0，そうでなければ (NaN を含めて) k を返し，
+        // std::min(k, 1.0) と一致する
+
+#ifdef DC_HAVE_X86_KERNELS
+        __attribute__((target("sse2")))
+        void
+        CircleKernel::integrate_sse2 (const Arrays& arrays)
+        {
+            const __m128d one = _mm_set1_pd(1.0);
+            const __m128d dt  = _mm_set1_pd(arrays.dt);
+            const std::size_t n = arrays.size & ~static_cast<std::size_t>(1);
+            std::size_t i;
+
+            for( i = 0; i < n; i += 2 )
+            {
+                const __m128d k  = _mm_min_pd(one, _mm_mul_pd(_mm_mul_pd(_mm_loadu_pd(arrays.visc_resist + i),
+                                                                         _mm_loadu_pd(arrays.radius + i)),
+                                                              dt));
+                __m128d vx = _mm_loadu_pd(arrays.vx + i);
+                __m128d vy = _mm_loadu_pd(arrays.vy + i);
+
+                vx = _mm_sub_pd(vx, _mm_mul_pd(k, vx));
+                vy = _mm_sub_pd(vy, _mm_mul_pd(k, vy));
+                _mm_storeu_pd(arrays.vx + i, vx);
+                _mm_storeu_pd(arrays.vy + i, vy);
+                _mm_storeu_pd(arrays.x + i, _mm_add_pd(_mm_loadu_pd(arrays.x + i), _mm_mul_pd(vx, dt)));
+                _mm_storeu_pd(arrays.y + i, _mm_add_pd(_mm_loadu_pd(arrays.y + i), _mm_mul_pd(vy, dt)));
+            }
+
+            integrate_scalar(arrays, n);
+        }
+
+        __attribute__((target("avx2")))
+        void
+        CircleKernel::integrate_avx2 (const Arrays& arrays)
+        {
+            const __m256d one = _mm256_set1_pd(1.0);
+            const __m256d dt  = _mm256_set1_pd(arrays.dt);
+            const std::size_t n = arrays.size & ~static_cast<std::size_t>(3);
+            std::size_t i;
+
+            for( i = 0; i < n; i += 4 )
+            {
+                const __m256d k  = _mm256_min_pd(one, _mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(arrays.visc_resist + i),
+                                                                                  _mm256_loadu_pd(arrays.radius + i)),
+                                                                    dt));
+                __m256d vx = _mm256_loadu_pd(arrays.vx + i);
+                __m256d vy = _mm256_loadu_pd(arrays.vy + i);
+
+                vx = _mm256_sub_pd(vx, _mm256_mul_pd(k, vx));
+                vy = _mm256_sub_pd(vy, _mm256_mul_pd(k, vy));
+                _mm256_storeu_pd(arrays.vx + i, vx);
+                _mm256_storeu_pd(arrays.vy + i, vy);
+                _mm256_storeu_pd(arrays.x + i, _mm256_add_pd(_mm256_loadu_pd(arrays.x + i), _mm256_mul_pd(vx, dt)));
+                _mm256_storeu_pd(arrays.y + i, _mm256_add_pd(_mm256_loadu_pd(arrays.y + i), _mm256_mul_pd(vy, dt)));
+            }
+
+            integrate_scalar(arrays, n);
+        }
+
+        __attribute__((target("sse2")))
+        void
+        CircleKernel::overlap_sse2 (const OverlapQuery& query)
+        {
+            const __m128d x = _mm_set1_pd(query.x);
+            const __m128d y = _mm_set1_pd(query.y);
+            const __m128d radius = _mm_set1_pd(query.radius);
+            const std::size_t n = query.size & ~static_cast<std::size_t>(1);
+            std::size_t i;
+
+            for( i = 0; i < n; i += 2 )
+            {
+                const __m128d dx = _mm_sub_pd(_mm_loadu_pd(query.other_x + i), x);
+                const __m128d dy = _mm_sub_pd(_mm_loadu_pd(query.other_y + i), y);
+                const __m128d r  = _mm_add_pd(radius, _mm_loadu_pd(query.other_radius + i));
+                const __m128d d2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+                const int mask = _mm_movemask_pd(_mm_cmpngt_pd(d2, _mm_mul_pd(r, r)));
+
+                query.hits[i]     = mask & 1;
+                query.hits[i + 1] = (mask >> 1) & 1;
+            }
+
+            overlap_scalar(query, n);
+        }
+
+        __attribute__((target("avx2")))
+        void
+        CircleKernel::overlap_avx2 (const OverlapQuery& query)
+        {
+            const __m256d x = _mm256_set1_pd(query.x);
+            const __m256d y = _mm256_set1_pd(query.y);
+            const __m256d radius = _mm256_set1_pd(query.radius);
+            const std::size_t n = query.size & ~static_cast<std::size_t>(3);
+            std::size_t i;
+
+            for( i = 0; i < n; i += 4 )
+            {
+                const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(query.other_x + i), x);
+                const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(query.other_y + i), y);
+                const __m256d r  = _mm256_add_pd(radius, _mm256_loadu_pd(query.other_radius + i));
+                const __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+                const int mask = _mm256_movemask_pd(_mm256_cmp_pd(d2, _mm256_mul_pd(r, r), _CMP_NGT_UQ));
+
+                query.hits[i]     = mask & 1;
+                query.hits[i + 1] = (mask >> 1) & 1;
+                query.hits[i + 2] = (mask >> 2) & 1;
+                query.hits[i + 3] = (mask >> 3) & 1;
+            }
+
+            overlap_scalar(query, n);
+        }
+#else
+        void
+        CircleKernel::integrate_sse2 (const Arrays& arrays)
+        {
+            integrate_scalar(arrays, 0);
+        }
+
+        void
+        CircleKernel::integrate_avx2 (const Arrays& arrays)
+        {
+            integrate_scalar(arrays, 0);
+        }
+
+        void
+        CircleKernel::overlap_sse2 (const OverlapQuery& query)
+        {
+            overlap_scalar(query, 0);
+        }
+
+        void
+        CircleKernel::overlap_avx2 (const OverlapQuery& query)
+        {
+            overlap_scalar(query, 0);
+        }
+#endif
+
+        /**
+         * @brief 選択されている実装で計算し，スカラー版の結果とビット単位で比較する
+         */
+        void
+        CircleKernel::verify_integrate (const Arrays& arrays)
+        {
+            const std::size_t n = arrays.size;
+            const Level level = get_level();
+            std::vector<double> x(arrays.x, arrays.x + n),
+                                y(arrays.y, arrays.y + n),
+                                vx(arrays.vx, arrays.vx + n),
+                                vy(arrays.vy, arrays.vy + n);
+            Arrays expected = arrays;
+
+            if( n == 0 ) return;
+
+            expected.x  = &x[0];
+            expected.y  = &y[0];
+            expected.vx = &vx[0];
+            expected.vy = &vy[0];
+            integrate_scalar(expected, 0);
+
+            integrate_level(level, arrays);
+
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                if( std::memcmp(&x[i],  arrays.x + i,  sizeof(double)) != 0 ||
+                    std::memcmp(&y[i],  arrays.y + i,  sizeof(double)) != 0 ||
+                    std::memcmp(&vx[i], arrays.vx + i, sizeof(double)) != 0 ||
+                    std::memcmp(&vy[i], arrays.vy + i, sizeof(double)) != 0 )
+                {
+                    dc_error("CircleKernel: '%s' の結果がスカラー版と一致しません (添字 %lu: (%.17g, %.17g) != (%.17g, %.17g))",
+                             get_level_name(level), (unsigned long) i,
+                             arrays.x[i], arrays.y[i], x[i], y[i]);
+                }
+            }
+        }
+
+        /**
+         * @brief 選択されている実装で重なりを調べ，スカラー版の結果と比較する
+         */
+        void
+        CircleKernel::verify_overlap (const OverlapQuery& query)
+        {
+            const Level level = get_level();
+            std::vector<unsigned char> hits(query.size);
+            OverlapQuery expected = query;
+
+            if( query.size == 0 ) return;
+
+            expected.hits = &hits[0];
+            overlap_scalar(expected, 0);
+
+            overlap_level(level, query);
+
+            for( std::size_t i = 0; i < query.size; ++i )
+            {
+                if( hits[i] != query.hits[i] )
+                {
+                    dc_error("CircleKernel: '%s' の重なり判定がスカラー版と一致しません (添字 %lu: %d != %d)",
+                             get_level_name(level), (unsigned long) i, query.hits[i], hits[i]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_5833BFE1_011F_4599_A5EE_9FF575D5F7CA
+#define INCLUDE_GUARD_5833BFE1_011F_4599_A5EE_9FF575D5F7CA
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <string>
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        /**
+         * @brief CircleStore の配列をまとめて処理する計算カーネル
+         *
+         *  SSE2 / AVX2 の実装を持ち，実行時に CPU が対応している最も速いものを選ぶ．
+         * どの実装もスカラー版とビット単位で同じ結果を返す (積和演算 (FMA) は使わない)．
+         * set_verify(true) とすると，毎回スカラー版と結果を比較して不一致を報告する．
+         */
+        class CircleKernel
+        {
+            public:
+                enum Level
+                {
+                    LEVEL_SCALAR,
+                    LEVEL_SSE2,
+                    LEVEL_AVX2
+                };
+
+                // integrate() が読み書きする配列 (要素数は全て size)
+                struct Arrays
+                {
+                    double       * x;
+                    double       * y;
+                    double       * vx;
+                    double       * vy;
+                    const double * radius;
+                    const double * visc_resist;
+                    std::size_t    size;
+                    double         dt; //< 時間刻み [s]
+                };
+
+                // overlap() の入出力 (1 つの円と，配列で与えた複数の円との重なりを調べる)
+                struct OverlapQuery
+                {
+                    double          x;
+                    double          y;
+                    double          radius; //< 許容誤差を含めた半径
+                    const double  * other_x;
+                    const double  * other_y;
+                    const double  * other_radius;
+                    std::size_t     size;
+                    unsigned char * hits; //< 重なり得るなら 1，確実に離れているなら 0
+                };
+
+                static Level        get_supported_level ();
+                static Level        get_level           ();
+                static bool         set_level           (Level level);
+                static bool         set_level           (const std::string& name);
+                static const char * get_level_name      (Level level);
+                static bool         get_verify          ();
+                static void         set_verify          (bool verify);
+                static void         integrate           (const Arrays& arrays);
+                static void         overlap             (const OverlapQuery& query);
+
+            private:
+                static void integrate_scalar (const Arrays& arrays,
+                                              std::size_t   first);
+                static void integrate_sse2   (const Arrays& arrays);
+                static void integrate_avx2   (const Arrays& arrays);
+                static void integrate_level  (Level         level,
+                                              const Arrays& arrays);
+                static void verify_integrate (const Arrays& arrays);
+
+                static void overlap_scalar   (const OverlapQuery& query,
+                                              std::size_t         first);
+                static void overlap_sse2     (const OverlapQuery& query);
+                static void overlap_avx2     (const OverlapQuery& query);
+                static void overlap_level    (Level               level,
+                                              const OverlapQuery& query);
+                static void verify_overlap   (const OverlapQuery& query);
+
+                static Level m_level;
+                static bool  m_level_inited;
+                static bool  m_verify;
+        };
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_5833BFE1_011F_4599_A5EE_9FF575D5F7CA */
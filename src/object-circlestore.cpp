@@ -0,0 +1,369 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include "error.hpp"
+#include "object-circle.hpp"
+#include "object-circlekernel.hpp"
+#include "object-circlestore.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        const std::size_t CircleStore::NO_SLOT;
+        // 基準の時間刻みで 1 tick あたり 0.01 px の移動量，30 tick に相当する
+        const double       CircleStore::m_sleep_speed = 0.01 / ObjectBase::get_reference_time_step(); // [px/s]
+        const double       CircleStore::m_sleep_time  = 30 * ObjectBase::get_reference_time_step(); // [s]
+        bool               CircleStore::m_sleep_enabled = true;
+
+        CircleStore::CircleStore ()
+            : m_n_active(0)
+        {
+        }
+
+        /**
+         * @brief 時間発展させない領域の末尾にスロットを確保する (状態は全て 0 で初期化する)
+         */
+        std::size_t
+        CircleStore::allocate (Circle& owner)
+        {
+            m_owners.push_back(&owner);
+            m_x.push_back(0.0);
+            m_y.push_back(0.0);
+            m_radius.push_back(0.0);
+            m_vx.push_back(0.0);
+            m_vy.push_back(0.0);
+            m_weight.push_back(0.0);
+            m_rest.push_back(0.0);
+            m_visc_resist.push_back(0.0);
+            m_still_time.push_back(0.0);
+            m_sleepable.push_back(1);
+            m_prev_x.push_back(0.0);
+            m_prev_y.push_back(0.0);
+            m_prev_radius.push_back(0.0);
+            m_prev_valid.push_back(0);
+
+            return m_owners.size() - 1;
+        }
+
+        /**
+         * @brief スロットを解放する (末尾のスロットと入れ替えてから取り除く)
+         */
+        void
+        CircleStore::release (std::size_t slot)
+        {
+            dc_return_if_fail(slot < size());
+
+            if( slot < m_n_active ) // 時間発展させる領域から外す
+            {
+                swap_slots(slot, m_n_active - 1);
+                slot = --m_n_active;
+            }
+            swap_slots(slot, size() - 1);
+
+            m_owners.pop_back();
+            m_x.pop_back();
+            m_y.pop_back();
+            m_radius.pop_back();
+            m_vx.pop_back();
+            m_vy.pop_back();
+            m_weight.pop_back();
+            m_rest.pop_back();
+            m_visc_resist.pop_back();
+            m_still_time.pop_back();
+            m_sleepable.pop_back();
+            m_prev_x.pop_back();
+            m_prev_y.pop_back();
+            m_prev_radius.pop_back();
+            m_prev_valid.pop_back();
+        }
+
+        /**
+         * @brief スロットを時間発展させる領域へ移す
+         */
+        void
+        CircleStore::activate (const std::size_t slot)
+        {
+            dc_return_if_fail(slot < size());
+            dc_return_if_fail(slot >= m_n_active);
+
+            swap_slots(slot, m_n_active++);
+        }
+
+        /**
+         * @brief スロットを時間発展させない領域へ移す (時間発展させる領域の末尾のスロットと入れ替える)
+         */
+        void
+        CircleStore::deactivate (const std::size_t slot)
+        {
+            dc_return_if_fail(slot < m_n_active);
+
+            swap_slots(slot, --m_n_active);
+        }
+
+        /**
+         * @brief 時間発展させる領域の全てのスロットについて，粘性抵抗で速度を減衰させてから
+         *        位置を時間 @c dt [s] だけ進める
+         */
+        void
+        CircleStore::integrate (const double dt)
+        {
+            integrate_range(0, m_n_active, dt);
+        }
+
+        /**
+         * @brief 時間発展させない領域のスロット @c slot を，integrate() と同じ計算で時間 @c dt [s]
+         *        だけ進める
+         */
+        void
+        CircleStore::integrate (const std::size_t slot,
+                                const double      dt)
+        {
+            dc_return_if_fail(slot >= m_n_active && slot < size());
+
+            integrate_range(slot, 1, dt);
+        }
+
+        /**
+         * @brief 時間発展させない領域のスロット @c slot を，時間刻み @c dt [s] の tick で
+         *        @c n_ticks 回 integrate() と update_sleep() を行った状態まで進める
+         *
+         *  計算は 1 tick ずつ同じ順序で行うので，時間発展させる領域に置いたままの場合と
+         * 結果は一致する．休眠している円は動かないので，何もしない．
+         */
+        void
+        CircleStore::replay (const std::size_t slot,
+                             const double      dt,
+                             unsigned long     n_ticks)
+        {
+            dc_return_if_fail(slot >= m_n_active && slot < size());
+
+            for( ; n_ticks > 0 && ! is_sleeping(slot); --n_ticks )
+            {
+                integrate_range(slot, 1, dt);
+                update_sleep_of(slot, dt);
+            }
+        }
+
+        /**
+         * @brief スロット [@c first, @c first + @c size) の速度を粘性抵抗で減衰させてから，
+         *        位置を時間 @c dt [s] だけ進める
+         */
+        void
+        CircleStore::integrate_range (const std::size_t first,
+                                      const std::size_t size,
+                                      const double      dt)
+        {
+            CircleKernel::Arrays arrays;
+
+            if( size == 0 ) return;
+
+            for( std::size_t i = first; i < first + size; ++i )
+            {
+                const double k = m_visc_resist[i] * m_radius[i] * dt;
+
+                if( k > 1.0 ) dc_warning("粘性抵抗力が 1.0 を超過しました (k = %g, radius = %g)\n", k, m_radius[i]);
+            }
+
+            arrays.x           = &m_x[first];
+            arrays.y           = &m_y[first];
+            arrays.vx          = &m_vx[first];
+            arrays.vy          = &m_vy[first];
+            arrays.radius      = &m_radius[first];
+            arrays.visc_resist = &m_visc_resist[first];
+            arrays.size        = size;
+            arrays.dt          = dt;
+            CircleKernel::integrate(arrays); // 1.0 を超えた係数は 1.0 に切り詰められる
+        }
+
+        /**
+         * @brief 時間発展させる領域の全てのスロットについて，現在の位置と半径を
+         *        前の tick の状態として保存する (tick の初めに呼び出す)
+         */
+        void
+        CircleStore::save_state ()
+        {
+            if( m_n_active == 0 ) return;
+
+            std::copy(m_x.begin(), m_x.begin() + m_n_active, m_prev_x.begin());
+            std::copy(m_y.begin(), m_y.begin() + m_n_active, m_prev_y.begin());
+            std::copy(m_radius.begin(), m_radius.begin() + m_n_active, m_prev_radius.begin());
+            std::fill(m_prev_valid.begin(), m_prev_valid.begin() + m_n_active, 1);
+        }
+
+        /**
+         * @brief スロット @c slot の現在の位置と半径を，前の tick の状態として保存する
+         */
+        void
+        CircleStore::save_state (const std::size_t slot)
+        {
+            dc_return_if_fail(slot < size());
+
+            m_prev_x[slot]      = m_x[slot];
+            m_prev_y[slot]      = m_y[slot];
+            m_prev_radius[slot] = m_radius[slot];
+            m_prev_valid[slot]  = 1;
+        }
+
+        /**
+         * @brief 時間発展させる領域の全てのスロットについて，静止している時間に @c dt を加え，
+         *        m_sleep_time に達した円を休眠させる (tick の最後に呼び出す)
+         *
+         *  休眠した円は速度を 0 にするので，integrate() で動くことはない．経過時間の丸め誤差で
+         * 1 tick 遅れないよう，m_sleep_time に最も近い tick で休眠させる．
+         */
+        void
+        CircleStore::update_sleep (const double dt)
+        {
+            for( std::size_t i = 0; i < m_n_active; ++i ) update_sleep_of(i, dt);
+        }
+
+        /**
+         * @brief スロット @c slot の円について，静止している時間に @c dt を加え，休眠させるかどうかを決める
+         */
+        void
+        CircleStore::update_sleep_of (const std::size_t slot,
+                                      const double      dt)
+        {
+            const double threshold = m_sleep_speed * m_sleep_speed;
+
+            if( ! m_sleep_enabled || ! m_sleepable[slot] || m_still_time[slot] >= m_sleep_time ) return;
+
+            if( m_vx[slot] * m_vx[slot] + m_vy[slot] * m_vy[slot] >= threshold )
+            {
+                m_still_time[slot] = 0.0;
+            }
+            else if( (m_still_time[slot] += dt) + 0.5 * dt >= m_sleep_time ) // 休眠する
+            {
+                m_still_time[slot] = m_sleep_time;
+                m_vx[slot] = 0.0;
+                m_vy[slot] = 0.0;
+            }
+        }
+
+        /**
+         * @brief 休眠しているスロット @c slot の円が他の物体と衝突したときに呼び出す
+         *
+         *  衝突で位置・大きさが変化した (@c moved が true) か，静止しているとみなせない速さを
+         * 与えられた円は起こす．そうでなければ速度を 0 に戻し，休眠を続ける．
+         */
+        void
+        CircleStore::disturb (const std::size_t slot,
+                              const bool        moved)
+        {
+            dc_return_if_fail(slot < size());
+
+            if( moved || m_vx[slot] * m_vx[slot] + m_vy[slot] * m_vy[slot] >= m_sleep_speed * m_sleep_speed )
+            {
+                wake(slot);
+            }
+            else
+            {
+                m_vx[slot] = 0.0;
+                m_vy[slot] = 0.0;
+            }
+        }
+
+        /**
+         * @brief 物体の休眠を行うかどうかを設定する (検証用)
+         */
+        void
+        CircleStore::set_sleep_enabled (const bool enabled)
+        {
+            m_sleep_enabled = enabled;
+        }
+
+        bool
+        CircleStore::get_sleep_enabled ()
+        {
+            return m_sleep_enabled;
+        }
+
+        /**
+         * @brief スロット @c slot の円と @c slots の各円が重なり得るかどうかを @c hits に求める
+         *
+         *  半径に @c margin を加えて判定するので，衝突判定の許容誤差の範囲で接している組も
+         * 重なり得るものとする．候補の状態は作業領域 @c gather に集めるので，円の状態を
+         * 変更しない間は，作業領域を分ければ複数のスレッドから同時に呼び出してよい．
+         */
+        void
+        CircleStore::test_overlap (const std::size_t               slot,
+                                   const double                    margin,
+                                   const std::vector<std::size_t>& slots,
+                                   Gather&                         gather,
+                                   std::vector<unsigned char>&     hits) const
+        {
+            const std::size_t n = slots.size();
+            CircleKernel::OverlapQuery query;
+
+            hits.resize(n);
+            if( n == 0 ) return;
+
+            // 候補の状態を連続した領域に集める
+            gather.x.resize(n);
+            gather.y.resize(n);
+            gather.radius.resize(n);
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                gather.x[i]      = m_x[slots[i]];
+                gather.y[i]      = m_y[slots[i]];
+                gather.radius[i] = m_radius[slots[i]];
+            }
+
+            query.x            = m_x[slot];
+            query.y            = m_y[slot];
+            query.radius       = m_radius[slot] + margin;
+            query.other_x      = &gather.x[0];
+            query.other_y      = &gather.y[0];
+            query.other_radius = &gather.radius[0];
+            query.size         = n;
+            query.hits         = &hits[0];
+            CircleKernel::overlap(query);
+        }
+
+        void
+        CircleStore::swap_slots (const std::size_t slot1,
+                                 const std::size_t slot2)
+        {
+            if( slot1 == slot2 ) return;
+
+            std::swap(m_owners[slot1], m_owners[slot2]);
+            std::swap(m_x[slot1], m_x[slot2]);
+            std::swap(m_y[slot1], m_y[slot2]);
+            std::swap(m_radius[slot1], m_radius[slot2]);
+            std::swap(m_vx[slot1], m_vx[slot2]);
+            std::swap(m_vy[slot1], m_vy[slot2]);
+            std::swap(m_weight[slot1], m_weight[slot2]);
+            std::swap(m_rest[slot1], m_rest[slot2]);
+            std::swap(m_visc_resist[slot1], m_visc_resist[slot2]);
+            std::swap(m_still_time[slot1], m_still_time[slot2]);
+            std::swap(m_sleepable[slot1], m_sleepable[slot2]);
+            std::swap(m_prev_x[slot1], m_prev_x[slot2]);
+            std::swap(m_prev_y[slot1], m_prev_y[slot2]);
+            std::swap(m_prev_radius[slot1], m_prev_radius[slot2]);
+            std::swap(m_prev_valid[slot1], m_prev_valid[slot2]);
+
+            m_owners[slot1]->m_slot = slot1;
+            m_owners[slot2]->m_slot = slot2;
+        }
+    }
+}
@@ -0,0 +1,169 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_7E62342C_C684_417F_B0E5_92070496FBA9
+#define INCLUDE_GUARD_7E62342C_C684_417F_B0E5_92070496FBA9
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <vector>
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        class Circle;
+
+        /**
+         * @brief 円形物体の状態 (位置・半径・速度など) を成分ごとの配列で保持する
+         *
+         *  各 Circle は自身の状態をここに置き，アクセサはスロット番号で配列を参照する．
+         * スロットは [0, get_n_active()) の「時間発展させる」領域と，それ以降の領域に
+         * 分かれる．Manager に登録された Globule だけが前者に置かれ，integrate() で
+         * まとめて時間を進める．Splitter の部品や fixed 物体 (Flicker など) は後者に置かれる．
+         *
+         *  スロットは領域を詰めるために入れ替わることがある (所有者の Circle::m_slot も
+         * 更新する) ので，スロット番号を保存してはならない．
+         *
+         *  時間発展させる領域のスロットは，tick の初めに save_state() で前の tick の位置と
+         * 半径を保存しておき，描画時には現在の状態との間を補間する．
+         *
+         *  速さが m_sleep_speed を下回る状態が m_sleep_time 秒続いた円は休眠し，
+         * 速度を 0 にしたまま衝突計算から外される (update_sleep() を参照)．
+         *
+         *  Manager::ENGINE_EVENT では，しばらく何とも衝突しない Globule を時間発展させない領域へ
+         * 移しておき (deactivate())，必要になった時点で replay() によって integrate() と
+         * update_sleep() を続けた場合と同じ状態まで進める．
+         */
+        class CircleStore
+        {
+            public:
+                static const std::size_t NO_SLOT = static_cast<std::size_t>(-1);
+
+                // test_overlap() で候補の状態を集める作業領域
+                struct Gather
+                {
+                    std::vector<double> x;
+                    std::vector<double> y;
+                    std::vector<double> radius;
+                };
+
+                CircleStore ();
+
+                std::size_t        allocate     (Circle& owner);
+                void               release      (std::size_t slot);
+                void               activate     (std::size_t slot);
+                void               deactivate   (std::size_t slot);
+                void               integrate    (double dt);
+                void               integrate    (std::size_t slot,
+                                                 double      dt);
+                void               replay       (std::size_t   slot,
+                                                 double        dt,
+                                                 unsigned long n_ticks);
+                void               test_overlap (std::size_t                     slot,
+                                                 double                          margin,
+                                                 const std::vector<std::size_t>& slots,
+                                                 Gather&                         gather,
+                                                 std::vector<unsigned char>&     hits) const;
+                void               save_state   ();
+                void               save_state   (std::size_t slot);
+                void               update_sleep (double dt);
+                inline bool        is_sleeping  (std::size_t slot) const;
+                inline void        wake         (std::size_t slot);
+                void               disturb      (std::size_t slot,
+                                                 bool        moved);
+                inline std::size_t get_n_active () const;
+                inline std::size_t size         () const;
+
+                static void        set_sleep_enabled (bool enabled);
+                static bool        get_sleep_enabled ();
+
+            private:
+                friend class Circle;
+                friend class Globule;
+
+                CircleStore (const CircleStore& other); // Do not call!
+                CircleStore& operator = (const CircleStore& other); // Do not call!
+
+                void swap_slots      (std::size_t slot1,
+                                      std::size_t slot2);
+                void integrate_range (std::size_t first,
+                                      std::size_t size,
+                                      double      dt);
+                void update_sleep_of (std::size_t slot,
+                                      double      dt);
+
+                std::vector<Circle *>      m_owners;
+                std::vector<double>        m_x;
+                std::vector<double>        m_y;
+                std::vector<double>        m_radius;
+                std::vector<double>        m_vx;
+                std::vector<double>        m_vy;
+                std::vector<double>        m_weight;
+                std::vector<double>        m_rest;
+                std::vector<double>        m_visc_resist; //< 粘性抵抗の係数 (抵抗を受けない物体は 0)
+                std::vector<double>        m_still_time;  //< 静止している状態が続いている時間 [s]
+                std::vector<unsigned char> m_sleepable;   //< 休眠させてよいかどうか (Ball は休眠しない)
+                std::size_t                m_n_active;    //< 時間発展させるスロットの数
+
+                // 前の tick の状態 (描画時の補間に使う)
+                std::vector<double>        m_prev_x;
+                std::vector<double>        m_prev_y;
+                std::vector<double>        m_prev_radius;
+                std::vector<unsigned char> m_prev_valid; //< 前の tick の状態を保存してあるかどうか
+
+                static const double        m_sleep_speed; //< これより遅い円は静止しているとみなす [px/s]
+                static const double        m_sleep_time;  //< 静止している状態がこの時間 [s] 続くと休眠する
+                static bool                m_sleep_enabled;
+        };
+
+        /**
+         * @brief スロット @c slot の円が休眠しているかどうか
+         */
+        inline bool
+        CircleStore::is_sleeping (const std::size_t slot) const
+        {
+            return m_still_time[slot] >= m_sleep_time;
+        }
+
+        /**
+         * @brief スロット @c slot の円を起こし，静止している時間を数え直す
+         */
+        inline void
+        CircleStore::wake (const std::size_t slot)
+        {
+            m_still_time[slot] = 0.0;
+        }
+
+        inline std::size_t
+        CircleStore::get_n_active () const
+        {
+            return m_n_active;
+        }
+
+        inline std::size_t
+        CircleStore::size () const
+        {
+            return m_owners.size();
+        }
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_7E62342C_C684_417F_B0E5_92070496FBA9 */
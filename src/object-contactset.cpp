@@ -0,0 +1,308 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "error.hpp"
+#include "object-contactset.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        Glib::StaticPrivate<ContactSet::Journal> ContactSet::m_journal = GLIBMM_STATIC_PRIVATE_INIT;
+
+        ContactSet::ContactSet ()
+            : m_curr(0),
+              m_pass(0)
+        {
+        }
+
+        void
+        ContactSet::clear ()
+        {
+            m_tables[0].clear();
+            m_tables[1].clear();
+        }
+
+        /**
+         * @brief tick を進める (現在の集合を直前の集合とし，現在の集合を空にする)
+         */
+        void
+        ContactSet::rotate ()
+        {
+            m_curr ^= 1;
+            m_pass  = 0;
+            m_tables[m_curr].clear();
+        }
+
+        /**
+         * @brief 現在の tick の中で，衝突計算の次の段階に進む
+         *
+         *  これより前に記録した組は，was_collided() で既に衝突していたものとして扱われる．
+         */
+        void
+        ContactSet::begin_pass ()
+        {
+            ++m_pass;
+        }
+
+        /**
+         * @brief 現在の tick で物体 @c id1 と @c id2 が衝突したことを記録する
+         *
+         *  この tick で初めて記録する組は，直前の tick の情報 (なければ空の情報) を引き継ぎ，
+         * 連続して接触している tick 数を 1 進める．
+         */
+        void
+        ContactSet::insert (const unsigned int id1,
+                            const unsigned int id2)
+        {
+            Journal * const journal = m_journal.get();
+
+            if( journal != 0 )
+            {
+                const Journal::Entry entry = {id1, id2, Vector<double>(0.0, 0.0), 0.0, -1, false};
+                journal->m_entries.push_back(entry);
+                return;
+            }
+
+            insert_internal(id1, id2);
+        }
+
+        /**
+         * @brief 現在の tick で物体 @c id1 と @c id2 が衝突したことを記録し，接触の情報を設定する
+         *
+         *  @c normal は ID の小さい物体から大きい物体へ向かう向きで渡す．
+         */
+        void
+        ContactSet::record (const unsigned int    id1,
+                            const unsigned int    id2,
+                            const Vector<double>& normal,
+                            const double          depth,
+                            const int             feature)
+        {
+            Journal * const journal = m_journal.get();
+
+            if( journal != 0 )
+            {
+                const Journal::Entry entry = {id1, id2, normal, depth, feature, true};
+                journal->m_entries.push_back(entry);
+                return;
+            }
+
+            Contact& contact = insert_internal(id1, id2);
+            contact.normal  = normal;
+            contact.depth   = depth;
+            contact.feature = feature;
+        }
+
+        /**
+         * @brief 呼び出したスレッドの以降の記録を，表の代わりに @c journal に控える
+         *
+         *  end_journal() を呼ぶまで続く．
+         */
+        void
+        ContactSet::begin_journal (Journal& journal)
+        {
+            m_journal.set(&journal, 0);
+        }
+
+        void
+        ContactSet::end_journal ()
+        {
+            m_journal.set(0, 0);
+        }
+
+        /**
+         * @brief @c journal に控えた記録のうち，@c first 番目から @c last の前までを表に反映する
+         *
+         *  記録を行うスレッドが動いていない間に呼び出す．記録した順に insert()・record() を
+         * 呼び出した場合と同じ結果になる．
+         */
+        void
+        ContactSet::commit (const Journal&    journal,
+                            const std::size_t first,
+                            const std::size_t last)
+        {
+            for( std::size_t i = first; i < last; ++i )
+            {
+                const Journal::Entry& entry = journal.m_entries[i];
+                Contact& contact = insert_internal(entry.id1, entry.id2);
+
+                if( entry.recorded )
+                {
+                    contact.normal  = entry.normal;
+                    contact.depth   = entry.depth;
+                    contact.feature = entry.feature;
+                }
+            }
+        }
+
+        ContactSet::Contact&
+        ContactSet::insert_internal (const unsigned int id1,
+                                     const unsigned int id2)
+        {
+            const guint64 key = make_key(id1, id2);
+            bool inserted;
+            Contact * const contact = m_tables[m_curr].insert(key, inserted);
+
+            if( inserted )
+            {
+                const Contact * const previous = m_tables[m_curr ^ 1].find(key);
+
+                if( previous != 0 )
+                {
+                    *contact = *previous;
+                    ++contact->age;
+                }
+                else
+                {
+                    contact->normal  = Vector<double>(0.0, 0.0);
+                    contact->depth   = 0.0;
+                    contact->feature = -1;
+                    contact->age     = 1;
+                }
+                contact->pass = m_pass;
+            }
+
+            return *contact;
+        }
+
+        /**
+         * @brief 物体 @c id1 と @c id2 が，直前の tick か現在の tick の前の段階で衝突していたかどうか
+         */
+        bool
+        ContactSet::was_collided (const unsigned int id1,
+                                  const unsigned int id2) const
+        {
+            const guint64 key = make_key(id1, id2);
+
+            if( m_tables[m_curr ^ 1].find(key) != 0 ) return true;
+            if( m_pass == 0 ) return false;
+
+            const Contact * const current = m_tables[m_curr].find(key);
+            return current != 0 && current->pass < m_pass;
+        }
+
+        /**
+         * @brief 直前の tick に記録した，物体 @c id1 と @c id2 の接触の情報を返す
+         *
+         * @return 直前の tick で衝突していなければ 0 を返す．
+         */
+        const ContactSet::Contact *
+        ContactSet::find_previous (const unsigned int id1,
+                                   const unsigned int id2) const
+        {
+            return m_tables[m_curr ^ 1].find(make_key(id1, id2));
+        }
+
+        /**
+         * @brief 現在の tick で衝突している組の数
+         */
+        std::size_t
+        ContactSet::size () const
+        {
+            return m_tables[m_curr].size();
+        }
+
+        /**********************************************************************
+         *  class ContactSet::Table
+         *********************************************************************/
+
+        ContactSet::Table::Table ()
+            : m_keys(16, 0),
+              m_values(16)
+        {
+        }
+
+        void
+        ContactSet::Table::clear ()
+        {
+            for( std::size_t i = 0; i < m_used.size(); ++i ) m_keys[m_used[i]] = 0;
+            m_used.clear();
+        }
+
+        /**
+         * @brief キー @c key の情報を置く場所を返す
+         *
+         *  新たに登録したときは @c inserted を true にする (情報の内容は不定)．
+         */
+        ContactSet::Contact *
+        ContactSet::Table::insert (const guint64 key,
+                                   bool&         inserted)
+        {
+            std::size_t slot;
+
+            if( 2 * (m_used.size() + 1) > m_keys.size() ) grow(); // 負荷率を 1/2 以下に保つ
+
+            for( slot = get_slot(key); m_keys[slot] != 0; slot = (slot + 1) & (m_keys.size() - 1) )
+            {
+                if( m_keys[slot] == key ) // 登録済み
+                {
+                    inserted = false;
+                    return &m_values[slot];
+                }
+            }
+
+            m_keys[slot] = key;
+            m_used.push_back(slot);
+
+            inserted = true;
+            return &m_values[slot];
+        }
+
+        const ContactSet::Contact *
+        ContactSet::Table::find (const guint64 key) const
+        {
+            for( std::size_t slot = get_slot(key); m_keys[slot] != 0; slot = (slot + 1) & (m_keys.size() - 1) )
+            {
+                if( m_keys[slot] == key ) return &m_values[slot];
+            }
+
+            return 0;
+        }
+
+        std::size_t
+        ContactSet::Table::size () const
+        {
+            return m_used.size();
+        }
+
+        void
+        ContactSet::Table::grow ()
+        {
+            std::vector<guint64> keys;
+            std::vector<Contact> values;
+            bool inserted;
+            std::size_t i;
+
+            for( i = 0; i < m_used.size(); ++i )
+            {
+                keys.push_back(m_keys[m_used[i]]);
+                values.push_back(m_values[m_used[i]]);
+            }
+
+            m_keys.assign(2 * m_keys.size(), 0);
+            m_values.resize(m_keys.size());
+            m_used.clear();
+
+            for( i = 0; i < keys.size(); ++i ) *insert(keys[i], inserted) = values[i];
+        }
+    }
+}
@@ -0,0 +1,192 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_8133F7EA_6DA7_4872_8814_687CB6776242
+#define INCLUDE_GUARD_8133F7EA_6DA7_4872_8814_687CB6776242
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <vector>
+#include <glibmm.h>
+#include "vector.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        /**
+         * @brief 衝突している物体の組 (オブジェクト ID の組) ごとの接触の記録
+         *
+         *  現在の tick と直前の tick の 2 つの表を持ち，rotate() で入れ替える．接触しなく
+         * なった組は，次の tick で記録されないので rotate() の 2 回目で消える．
+         * 追加・検索は O(1)，rotate() は直前の tick に記録された組の数に比例する
+         * (物体の数にはよらない)．
+         *
+         *  1 つの tick の中で衝突計算を何段階かに分けて行う場合 (tick を分割した移動など) は，
+         * 段階の境目で begin_pass() を呼ぶ．前の段階で記録した組は，直前の tick の組と同じく
+         * 既に衝突していたものとして was_collided() が扱うので，衝突の応答が重複しない．
+         *
+         *  複数のスレッドから同時に記録する場合 (島ごとの衝突計算) は，各スレッドが
+         * begin_journal() で自分の Journal を指定し，insert()・record() の記録をそこに控える．
+         * 控えた記録は，スレッドが動いていない間に commit() で決まった順に表へ反映するので，
+         * 表の内容はスレッドの割り当てによらない．控えている間も直前の tick と前の段階の
+         * 情報は参照できる (was_collided() は現在の段階の記録を参照しない)．
+         */
+        class ContactSet
+        {
+            public:
+                /**
+                 * @brief 1 つの接触の情報
+                 *
+                 *  法線は ID の小さい物体から大きい物体へ向かう向きで保持する
+                 * (ObjectBase::record_contact() などが向きをそろえる)．
+                 */
+                struct Contact
+                {
+                    Vector<double> normal;  //< 接触点の法線 (単位ベクトル，未記録なら 0)
+                    double         depth;   //< めり込みの深さ [px]
+                    int            feature; //< 接触した部分の番号 (Polygon の辺など，なければ -1)
+                    unsigned int   age;     //< 連続して接触している tick 数 (初めて接触した tick で 1)
+                    unsigned int   pass;    //< 現在の tick で初めて記録した段階の番号
+                };
+
+                /**
+                 * @brief 1 つのスレッドが控えた記録 (commit() で表に反映する)
+                 */
+                class Journal
+                {
+                    public:
+                        inline void        clear ();
+                        inline std::size_t size  () const;
+
+                    private:
+                        friend class ContactSet;
+
+                        struct Entry
+                        {
+                            unsigned int   id1;
+                            unsigned int   id2;
+                            Vector<double> normal;
+                            double         depth;
+                            int            feature;
+                            bool           recorded; //< 接触の情報を設定する (record() の記録)
+                        };
+
+                        std::vector<Entry> m_entries;
+                };
+
+                ContactSet ();
+
+                void            clear          ();
+                void            rotate         ();
+                void            insert         (unsigned int id1,
+                                                unsigned int id2);
+                void            record         (unsigned int          id1,
+                                                unsigned int          id2,
+                                                const Vector<double>& normal,
+                                                double                depth,
+                                                int                   feature);
+                void            begin_pass     ();
+                void            begin_journal  (Journal& journal);
+                void            end_journal    ();
+                void            commit         (const Journal& journal,
+                                                std::size_t    first,
+                                                std::size_t    last);
+                bool            was_collided   (unsigned int id1,
+                                                unsigned int id2) const;
+                const Contact * find_previous  (unsigned int id1,
+                                                unsigned int id2) const;
+                std::size_t     size           () const;
+
+            private:
+                // 開番地法によるハッシュ集合 (キー 0 は空きを表す)
+                class Table
+                {
+                    public:
+                        Table ();
+
+                        void            clear  ();
+                        Contact *       insert (guint64 key,
+                                                bool&   inserted);
+                        const Contact * find   (guint64 key) const;
+                        std::size_t     size   () const;
+
+                    private:
+                        inline std::size_t get_slot (guint64 key) const;
+                        void               grow     ();
+
+                        std::vector<guint64>     m_keys;
+                        std::vector<Contact>     m_values; //< m_keys と同じスロットに置く
+                        std::vector<std::size_t> m_used; //< 使用中のスロット (clear() を高速化するため)
+                };
+
+                static inline guint64 make_key (unsigned int id1,
+                                                unsigned int id2);
+
+                Contact& insert_internal (unsigned int id1,
+                                          unsigned int id2);
+
+                static Glib::StaticPrivate<Journal> m_journal; //< スレッドごとの記録の控え先 (0 なら表に直接記録する)
+
+                Table         m_tables[2];
+                unsigned int  m_curr; //< 現在の tick の集合の番号
+                unsigned int  m_pass; //< 現在の tick の中での衝突計算の段階の番号 (rotate() で 0 に戻る)
+        };
+
+        inline void
+        ContactSet::Journal::clear ()
+        {
+            m_entries.clear();
+        }
+
+        /**
+         * @brief 控えた記録の数 (commit() に渡す範囲の位置に使う)
+         */
+        inline std::size_t
+        ContactSet::Journal::size () const
+        {
+            return m_entries.size();
+        }
+
+        /**
+         * @brief ID の組を順序に依存しないキーに変換する
+         *
+         *  小さい方の ID を上位に置き，大きい方の ID に 1 を足して下位に置くので，キーは 0 に
+         * ならない．
+         */
+        inline guint64
+        ContactSet::make_key (const unsigned int id1,
+                              const unsigned int id2)
+        {
+            if( id1 < id2 ) return (static_cast<guint64>(id1) << 32) | (static_cast<guint64>(id2) + 1);
+            else            return (static_cast<guint64>(id2) << 32) | (static_cast<guint64>(id1) + 1);
+        }
+
+        inline std::size_t
+        ContactSet::Table::get_slot (const guint64 key) const
+        {
+            // Fibonacci hashing (m_keys.size() は 2 のべき乗)
+            const guint64 h = key * G_GUINT64_CONSTANT(0x9E3779B97F4A7C15);
+            return static_cast<std::size_t>(h >> 32) & (m_keys.size() - 1);
+        }
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_8133F7EA_6DA7_4872_8814_687CB6776242 */
@@ -29,30 +29,34 @@ namespace DropletCollection
     {
         Glib::Rand   Droplet::m_rand;
         bool         Droplet::m_rand_inited      = false;
-        const double Droplet::m_init_speed_max   = 3;
-        const double Droplet::m_visc_resist      = 1e-3;
-        const int    Droplet::m_effect_count_max = 20;
+        // 速度・時間の定数は，基準の時間刻みでの 1 tick あたりの値から換算する
+        const double Droplet::m_init_speed_max   = 3 / ObjectBase::get_reference_time_step(); // [px/s]
+        const double Droplet::m_visc_resist      = 1e-3 / ObjectBase::get_reference_time_step(); // [1/(px s)]
+        const double Droplet::m_effect_duration  = 20 * ObjectBase::get_reference_time_step(); // 吸収エフェクトを表示する時間 [s]
         const double Droplet::m_effect_radius    = 10.0;
 
         Droplet::Droplet (Manager& manager)
             : Globule(manager),
-              m_effect_count(-1),
+              m_effect_tick(0),
               m_group_id(0),
               m_bg_color(0.0, 0.0, 0.0),
               m_line_color(0.0, 0.0, 0.0),
               m_effect_color(0.0, 0.0, 0.0)
         {
+            set_visc_resist(m_visc_resist); // 速度の減衰は CircleStore::integrate() で行う
+
             if( register_class("Droplet") )
             {
                 register_function("Droplet",
-                                  (CollideFunc) &Droplet::collide_with_droplet);
+                                  (DetectFunc) &Circle::detect_circle,
+                                  (RespondFunc) &Droplet::collide_with_droplet);
             }
         }
 
         Droplet::Droplet (Manager&       manager,
                           const Droplet& other)
             : Globule(manager, other),
-              m_effect_count(-1),
+              m_effect_tick(0),
               m_group_id(other.m_group_id),
               m_bg_color(other.m_bg_color),
               m_line_color(other.m_line_color),
@@ -96,23 +100,6 @@ namespace DropletCollection
             set_velocity(m_rand.get_double_range(0.0, m_init_speed_max) * norm);
         }
 
-        void
-        Droplet::advance ()
-        {
-            Vector<double> v = get_velocity();
-            double k = m_visc_resist * get_radius();
-
-            if( k > 1.0 )
-            {
-                dc_warning("粘性抵抗力が 1.0 を超過しました (k = %g, radius = %g)\n", k, get_radius());
-                k = 1.0;
-            }
-
-            set_velocity(v - k * v);
-
-            Globule::advance();
-        }
-
         void
         Droplet::load (const SettingFile& file)
         {
@@ -123,12 +110,12 @@ namespace DropletCollection
             m_effect_color = file.get_color(get_name(), "EffectColor");
             set_group_id(file.get_double(get_name(), "ID", 0, 255));
 
-            // 速度ベクトルの取得
+            // 速度ベクトルの取得 (1 tick あたりの値を秒あたりに換算する)
             if( file.has_key(get_name(), "Vx") && file.has_key(get_name(), "Vy") )
             {
                 double vx, vy;
-                vx = file.get_double(get_name(), "Vx", 0, 255);
-                vy = file.get_double(get_name(), "Vy", 0, 255);
+                vx = file.get_double(get_name(), "Vx", 0, 255) / get_reference_time_step();
+                vy = file.get_double(get_name(), "Vy", 0, 255) / get_reference_time_step();
                 set_velocity(Vector<double>(vx, vy));
             }
             else
@@ -138,15 +125,19 @@ namespace DropletCollection
         }
 
         void
-        Droplet::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        Droplet::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                       const double                         alpha) const
         {
+            const Vector<double> p      = get_draw_position(alpha);
+            const double         radius = get_draw_radius(alpha);
+
             cr->set_source_rgba(m_bg_color.red,
                                 m_bg_color.green,
                                 m_bg_color.blue,
                                 m_bg_color.alpha);
-            cr->arc(get_position().get_x(),
-                    get_position().get_y(),
-                    get_radius(),
+            cr->arc(p.get_x(),
+                    p.get_y(),
+                    radius,
                     0.0, 2.0 * M_PI);
             cr->fill_preserve();
             cr->set_source_rgba(m_line_color.red,
@@ -155,60 +146,53 @@ namespace DropletCollection
                                 m_line_color.alpha);
             cr->stroke();
 
-            // 吸収エフェクトを表示する
-            if( m_effect_count >= 0 )
+            // 吸収エフェクトを表示する (経過時間は描画の回数によらず，tick 数と alpha で決める)
+            if( m_effect_tick != 0 )
             {
-                double alpha = (double)(m_effect_count_max - m_effect_count) / m_effect_count_max;
-
-                cr->set_source_rgba(m_effect_color.red,
-                                    m_effect_color.green,
-                                    m_effect_color.blue,
-                                    alpha);
-                cr->arc(get_position().get_x(),
-                        get_position().get_y(),
-                        get_radius() + m_effect_radius * m_effect_count / m_effect_count_max,
-                        0.0, 2.0 * M_PI);
-                cr->stroke();
-
-                if( m_effect_count == m_effect_count_max )
-                {
-                    m_effect_count = -1;
-                }
-                else
+                const double time = ((get_manager().get_tick() - m_effect_tick) + alpha) * get_manager().get_time_step();
+
+                if( time <= m_effect_duration )
                 {
-                    ++m_effect_count;
+                    cr->set_source_rgba(m_effect_color.red,
+                                        m_effect_color.green,
+                                        m_effect_color.blue,
+                                        (m_effect_duration - time) / m_effect_duration);
+                    cr->arc(p.get_x(),
+                            p.get_y(),
+                            radius + m_effect_radius * time / m_effect_duration,
+                            0.0, 2.0 * M_PI);
+                    cr->stroke();
                 }
             }
         }
 
+        /**
+         * @brief Droplet 同士の衝突に応答する (接触は Circle::detect_circle() で検出する)
+         */
         bool
-        Droplet::collide_with_droplet (Droplet& self,
-                                       Droplet& other)
+        Droplet::collide_with_droplet (Droplet&        self,
+                                       Droplet&        other,
+                                       const Manifold& manifold)
         {
             if( self.m_group_id == other.m_group_id ) // 同じグループなら小滴は合成する
             {
-                if( fge(self.get_distance(other), 0.0) )
-                {
-                    double sum = self.get_weight() + other.get_weight();
-                    double wa  = self.get_weight() / sum; // self の相対質量比
-                    double wb  = other.get_weight() / sum; // other の相対質量比
+                double sum = self.get_weight() + other.get_weight();
+                double wa  = self.get_weight() / sum; // self の相対質量比
+                double wb  = other.get_weight() / sum; // other の相対質量比
 
-                    self.set_position(wa * self.get_position() + wb * other.get_position());
-                    self.set_velocity(wa * self.get_velocity() + wb * other.get_velocity());
-                    self.set_radius(std::sqrt(self.get_radius() * self.get_radius() +
-                                              other.get_radius() * other.get_radius())); // 面積が等しくなるように，半径を設定
+                self.set_position(wa * self.get_position() + wb * other.get_position());
+                self.set_velocity(wa * self.get_velocity() + wb * other.get_velocity());
+                self.set_radius(std::sqrt(self.get_radius() * self.get_radius() +
+                                          other.get_radius() * other.get_radius())); // 面積が等しくなるように，半径を設定
 
-                    self.m_effect_count = 0; // 吸収エフェクトの表示を開始する
-                    other.set_alive(false); // other を削除する
-
-                    return true;
-                }
+                self.m_effect_tick = self.get_manager().get_tick(); // 吸収エフェクトの表示を開始する
+                other.set_alive(false); // other を削除する
 
-                return false;
+                return true;
             }
             else // グループが異なる小滴同士の衝突
             {
-                return Globule::collide_with_globule(self, other);
+                return Globule::collide_with_globule(self, other, manifold);
             }
         }
     }
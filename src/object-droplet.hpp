@@ -43,10 +43,11 @@ namespace DropletCollection
                 void               set_random_velocity  ();
                 void               set_random_velocity  (const Vector<double>& norm);
                 virtual void       load                 (const SettingFile& file);
-                virtual void       advance              ();
-                virtual void       draw                 (const Cairo::RefPtr<Cairo::Context>& cr) const;
-                static bool        collide_with_droplet (Droplet& self,
-                                                         Droplet& other);
+                virtual void       draw                 (const Cairo::RefPtr<Cairo::Context>& cr,
+                                                         double                               alpha) const;
+                static bool        collide_with_droplet (Droplet&        self,
+                                                         Droplet&        other,
+                                                         const Manifold& manifold);
 
             protected:
                 inline void set_group_id (int group_id);
@@ -56,10 +57,10 @@ namespace DropletCollection
                 static bool         m_rand_inited;
                 static const double m_init_speed_max;
                 static const double m_visc_resist;
-                static const int    m_effect_count_max;
+                static const double m_effect_duration;
                 static const double m_effect_radius;
 
-                mutable int m_effect_count;
+                unsigned long m_effect_tick; //< 吸収エフェクトを始めた tick (0 なら表示しない)
                 int m_group_id;
                 Color m_bg_color;
                 Color m_line_color;
@@ -75,6 +76,9 @@ namespace DropletCollection
         inline void
         Droplet::set_group_id (const int group_id)
         {
+            // 登録済みであれば，ゲームクリアの判定に使うグループごとの数を更新させる
+            if( get_manager().exists(*this) ) get_manager().change_group(m_group_id, group_id);
+
             m_group_id = group_id;
         }
     }
@@ -19,6 +19,7 @@
 #  include "config.h"
 #endif
 
+#include <algorithm>
 #include "error.hpp"
 #include "object-ball.hpp"
 #include "object-globule.hpp"
@@ -39,9 +40,11 @@ namespace DropletCollection
             if( register_class("Field") )
             {
                 register_function("Globule",
-                                  (CollideFunc) &Field::collide_with_globule);
+                                  (DetectFunc) &Field::detect_globule,
+                                  (RespondFunc) &Field::collide_with_globule);
                 register_function("Ball",
-                                  (CollideFunc) &Field::collide_with_ball);
+                                  (DetectFunc) &Field::detect_ball,
+                                  (RespondFunc) &Field::collide_with_ball);
             }
         }
 
@@ -81,7 +84,8 @@ namespace DropletCollection
         }
 
         void
-        Field::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        Field::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                     const double                         alpha G_GNUC_UNUSED) const
         {
             dc_return_if_fail(cr != 0);
             dc_return_if_fail(m_image != 0);
@@ -90,47 +94,140 @@ namespace DropletCollection
             cr->paint();
         }
 
+        /**
+         * @brief 矩形 @c box と，最も近い壁との隙間を求める
+         */
         bool
-        Field::collide_with_globule (Field&   self,
-                                     Globule& other)
+        Field::get_clearance (const BoundingBox& box,
+                              double&            clearance) const
+        {
+            clearance = std::min(std::min(box.left - m_left, m_right - box.right),
+                                 std::min(box.top - m_top, m_bottom - box.bottom));
+            return true;
+        }
+
+        /**
+         * @brief 移動する円 @c other が，最初に接触する壁の時刻を求める
+         *
+         *  Ball には下端の壁がない (Racket で受ける) ので，Ball の場合は下端を調べない．
+         */
+        bool
+        Field::sweep (const Globule&        other,
+                      const Vector<double>& start,
+                      const Vector<double>& motion,
+                      double&               toi) const
+        {
+            static const ClassId ball_class = intern_class("Ball");
+            const Vector<double> end = start + motion;
+            const double radius = other.get_radius();
+            bool hit = false;
+            double t;
+
+            toi = 1.0;
+
+            // 各壁について，円と壁の隙間が移動の前後でどう変わるかを調べる
+            if( sweep_gap(start.get_x() - radius - m_left, end.get_x() - radius - m_left, t) ) // 左端
+            {
+                toi = std::min(toi, t); hit = true;
+            }
+            if( sweep_gap(m_right - start.get_x() - radius, m_right - end.get_x() - radius, t) ) // 右端
+            {
+                toi = std::min(toi, t); hit = true;
+            }
+            if( sweep_gap(start.get_y() - radius - m_top, end.get_y() - radius - m_top, t) ) // 上端
+            {
+                toi = std::min(toi, t); hit = true;
+            }
+            if( ! other.is(ball_class) &&
+                sweep_gap(m_bottom - start.get_y() - radius, m_bottom - end.get_y() - radius, t) ) // 下端
+            {
+                toi = std::min(toi, t); hit = true;
+            }
+
+            return hit;
+        }
+
+        /**
+         * @brief 円 @c other の，左端・右端・上端・下端の壁へのめり込みの深さを求める
+         *
+         *  深さが正の壁と衝突している．
+         */
+        void
+        Field::get_depths (const Globule& other,
+                           double         depths[N_WALLS]) const
         {
             const Vector<double>& p = other.get_position();
             const double radius = other.get_radius();
+
+            depths[0] = radius + m_left - p.get_x();   // 左端
+            depths[1] = radius - m_right + p.get_x();  // 右端
+            depths[2] = radius + m_top - p.get_y();    // 上端
+            depths[3] = radius - m_bottom + p.get_y(); // 下端
+        }
+
+        bool
+        Field::detect_globule (const Field&   self,
+                               const Globule& other,
+                               Manifold&      manifold G_GNUC_UNUSED)
+        {
+            double depths[N_WALLS];
+
+            self.get_depths(other, depths);
+
+            return depths[0] > 0.0 || depths[1] > 0.0 || depths[2] > 0.0 || depths[3] > 0.0;
+        }
+
+        /**
+         * @brief Ball は下端の壁と衝突しない (Racket で受ける)
+         */
+        bool
+        Field::detect_ball (const Field& self,
+                            const Ball&  other,
+                            Manifold&    manifold G_GNUC_UNUSED)
+        {
+            double depths[N_WALLS];
+
+            self.get_depths(other, depths);
+
+            return depths[0] > 0.0 || depths[1] > 0.0 || depths[2] > 0.0;
+        }
+
+        /**
+         * @brief 壁との衝突に応答する
+         *
+         *  接触の情報は使わず，壁ごとの深さを求め直す (比較だけなので軽い)．
+         */
+        bool
+        Field::collide_with_globule (Field&          self,
+                                     Globule&        other,
+                                     const Manifold& manifold G_GNUC_UNUSED)
+        {
+            double depths[N_WALLS];
             bool res1, res2, res3, res4;
 
-            res1 = collide_with_line(other,
-                                     Vector<double>(1.0, 0.0),
-                                     radius + self.m_left - p.get_x()); // 左端
-            res2 = collide_with_line(other,
-                                     Vector<double>(-1.0, 0.0),
-                                     radius - self.m_right + p.get_x()); // 右端
-            res3 = collide_with_line(other,
-                                     Vector<double>(0.0, 1.0),
-                                     radius + self.m_top - p.get_y()); // 上端
-            res4 = collide_with_line(other,
-                                     Vector<double>(0.0, -1.0),
-                                     radius - self.m_bottom + p.get_y()); // 下端
+            self.get_depths(other, depths);
+
+            res1 = collide_with_line(other, Vector<double>(1.0, 0.0), depths[0]);  // 左端
+            res2 = collide_with_line(other, Vector<double>(-1.0, 0.0), depths[1]); // 右端
+            res3 = collide_with_line(other, Vector<double>(0.0, 1.0), depths[2]);  // 上端
+            res4 = collide_with_line(other, Vector<double>(0.0, -1.0), depths[3]); // 下端
 
             return res1 || res2 || res3 || res4;
         }
 
         bool
-        Field::collide_with_ball (Field& self,
-                                  Ball&  other)
+        Field::collide_with_ball (Field&          self,
+                                  Ball&           other,
+                                  const Manifold& manifold G_GNUC_UNUSED)
         {
-            const Vector<double>& p = other.get_position();
-            const double radius = other.get_radius();
+            double depths[N_WALLS];
             bool res1, res2, res3;
 
-            res1 = collide_with_line(other,
-                                     Vector<double>(1.0, 0.0),
-                                     radius + self.m_left - p.get_x()); // 左端
-            res2 = collide_with_line(other,
-                                     Vector<double>(-1.0, 0.0),
-                                     radius - self.m_right + p.get_x()); // 右端
-            res3 = collide_with_line(other,
-                                     Vector<double>(0.0, 1.0),
-                                     radius + self.m_top - p.get_y()); // 上端
+            self.get_depths(other, depths);
+
+            res1 = collide_with_line(other, Vector<double>(1.0, 0.0), depths[0]);  // 左端
+            res2 = collide_with_line(other, Vector<double>(-1.0, 0.0), depths[1]); // 右端
+            res3 = collide_with_line(other, Vector<double>(0.0, 1.0), depths[2]);  // 上端
 
             return res1 || res2 || res3;
         }
@@ -150,9 +247,10 @@ namespace DropletCollection
                     v.set_x(-other.get_restitution() * v.get_x());
                     other.set_velocity(norm.nob_compose(v));
                 }
-                else if( feq(ip, 0.0) ) // 擬似非弾性衝突を計算する
+                else if( feq(ip, 0.0) ) // 擬似非弾性衝突を計算する (食い込みを 1 基準 tick で解消する)
                 {
-                    other.set_velocity(other.get_velocity() + distance * other.get_restitution() * norm);
+                    const double rate = 1.0 / get_reference_time_step();
+                    other.set_velocity(other.get_velocity() + distance * rate * other.get_restitution() * norm);
                 }
 
                 return true;
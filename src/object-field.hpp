@@ -39,20 +39,40 @@ namespace DropletCollection
                 explicit Field (Manager& manager);
                 virtual ~Field ();
 
-                inline double get_width            () const;
-                inline double get_height           () const;
-                void          set_region           (double x,
-                                                    double y,
-                                                    double width,
-                                                    double height);
-                virtual void  load                 (const SettingFile& file);
-                virtual void  draw                 (const Cairo::RefPtr<Cairo::Context>& cr) const;
-                static bool   collide_with_globule (Field&   self,
-                                                    Globule& other);
-                static bool   collide_with_ball    (Field&   self,
-                                                    Ball&    other);
+                inline double      get_width            () const;
+                inline double      get_height           () const;
+                inline BoundingBox get_region           () const;
+                void               set_region           (double x,
+                                                         double y,
+                                                         double width,
+                                                         double height);
+                virtual void       load                 (const SettingFile& file);
+                virtual void       draw                 (const Cairo::RefPtr<Cairo::Context>& cr,
+                                                         double                               alpha) const;
+                virtual bool       get_clearance        (const BoundingBox& box,
+                                                         double&            clearance) const;
+                virtual bool       sweep                (const Globule&        other,
+                                                         const Vector<double>& start,
+                                                         const Vector<double>& motion,
+                                                         double&               toi) const;
+                static bool        collide_with_globule (Field&          self,
+                                                         Globule&        other,
+                                                         const Manifold& manifold);
+                static bool        collide_with_ball    (Field&          self,
+                                                         Ball&           other,
+                                                         const Manifold& manifold);
 
             private:
+                enum { N_WALLS = 4 };
+
+                void        get_depths           (const Globule&        other,
+                                                  double                depths[N_WALLS]) const;
+                static bool detect_globule       (const Field&          self,
+                                                  const Globule&        other,
+                                                  Manifold&             manifold);
+                static bool detect_ball          (const Field&          self,
+                                                  const Ball&           other,
+                                                  Manifold&             manifold);
                 static bool collide_with_line    (Globule&              other,
                                                   const Vector<double>& norm,
                                                   double                distance);
@@ -79,6 +99,12 @@ namespace DropletCollection
 
             return m_image->get_height();
         }
+
+        inline BoundingBox
+        Field::get_region () const
+        {
+            return BoundingBox(m_left, m_top, m_right, m_bottom);
+        }
     }
 }
 
@@ -20,6 +20,7 @@
 #endif
 
 #include "error.hpp"
+#include "object-manager.hpp"
 #include "object-globule.hpp"
 #include "object-ball.hpp"
 #include "object-flicker.hpp"
@@ -28,21 +29,23 @@ namespace DropletCollection
 {
     namespace Object
     {
-        const int    Flicker::m_effect_count_max = 20; // 衝突エフェクトを表示する時間
+        const double Flicker::m_effect_duration  = 20 * ObjectBase::get_reference_time_step(); // 衝突エフェクトを表示する時間 [s]
         const double Flicker::m_effect_motion    = 2.0; // 衝突エフェクトにおけるズレの大きさ
 
         Flicker::Flicker (Manager& manager)
             : Circle(manager, false),
               m_speed(1.0),
               m_image(0),
-              m_effect_count(-1)
+              m_effect_tick(0)
         {
             if( register_class("Flicker") )
             {
                 register_function("Globule",
-                                  (CollideFunc) &Flicker::collide_with_globule);
+                                  (DetectFunc) &Circle::detect_circle,
+                                  (RespondFunc) &Flicker::collide_with_globule);
                 register_function("Ball",
-                                  (CollideFunc) &Flicker::collide_with_ball);
+                                  (DetectFunc) &Circle::detect_circle,
+                                  (RespondFunc) &Flicker::collide_with_ball);
             }
         }
 
@@ -51,7 +54,7 @@ namespace DropletCollection
             : Circle(manager, other),
               m_speed(other.m_speed),
               m_image(other.m_image),
-              m_effect_count(-1)
+              m_effect_tick(0)
         {
         }
 
@@ -60,19 +63,23 @@ namespace DropletCollection
         {
             Circle::load(file);
 
-            m_speed = file.get_double(get_name(), "Speed", 1, 255);
+            // 1 tick あたりの値を秒あたりに換算する
+            m_speed = file.get_double(get_name(), "Speed", 1, 255) / get_reference_time_step();
             m_image = file.get_image(get_name(), "Image");
         }
 
         void
-        Flicker::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        Flicker::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                       const double                         alpha G_GNUC_UNUSED) const
         {
             dc_return_if_fail(m_image != 0);
             dc_return_if_fail(cr != 0);
 
             Vector<double> p = get_position() - get_radius();
 
-            if( m_effect_count >= 0 )
+            // 衝突エフェクトは描画の回数によらず，経過した tick 数で表示する時間を決める
+            if( m_effect_tick != 0 &&
+                (get_manager().get_tick() - m_effect_tick) * get_manager().get_time_step() < m_effect_duration )
             {
                 Glib::Rand& rand = get_random();
 
@@ -80,52 +87,49 @@ namespace DropletCollection
                                                           +m_effect_motion),
                                     rand.get_double_range(-m_effect_motion,
                                                           +m_effect_motion));
-
-                if( ++m_effect_count == m_effect_count_max ) m_effect_count = -1;
             }
 
             Gdk::Cairo::set_source_pixbuf(cr, m_image, p.get_x(), p.get_y());
             cr->paint();
         }
 
+        /**
+         * @brief Flicker と Globule の衝突に応答する (接触は Circle::detect_circle() で検出する)
+         */
         bool
-        Flicker::collide_with_globule (const Flicker& self,
-                                       Globule&       other)
+        Flicker::collide_with_globule (const Flicker&  self,
+                                       Globule&        other,
+                                       const Manifold& manifold)
         {
-            if( fge(self.get_distance(other), 0.0) )
-            {
-                if( ! self.is_collided(other) )
-                {
-                    Vector<double> norm = self.get_norm_to(other);
-                    other.set_velocity(self.m_speed * norm);
+            const Vector<double> norm = -manifold.normal; // Globule へ向かう向き
+            self.record_contact(other, norm, manifold.distance);
 
-                    self.m_effect_count = 0; // 衝突エフェクトの表示を始める
-                }
+            if( ! self.is_collided(other) )
+            {
+                other.set_velocity(self.m_speed * norm);
 
-                return true;
+                self.m_effect_tick = self.get_manager().get_tick(); // 衝突エフェクトの表示を始める
             }
 
-            return false;
+            return true;
         }
 
         bool
-        Flicker::collide_with_ball (const Flicker& self,
-                                    Ball&          other)
+        Flicker::collide_with_ball (const Flicker&  self,
+                                    Ball&           other,
+                                    const Manifold& manifold)
         {
-            if( fge(self.get_distance(other), 0.0) )
-            {
-                if( ! self.is_collided(other) )
-                {
-                    Vector<double> norm = self.get_norm_to(other);
-                    other.set_velocity(other.get_speed() * norm);
+            const Vector<double> norm = -manifold.normal; // Ball へ向かう向き
+            self.record_contact(other, norm, manifold.distance);
 
-                    self.m_effect_count = 0; // 衝突エフェクトの表示を始める
-                }
+            if( ! self.is_collided(other) )
+            {
+                other.set_velocity(other.get_speed() * norm);
 
-                return true;
+                self.m_effect_tick = self.get_manager().get_tick(); // 衝突エフェクトの表示を始める
             }
 
-            return false;
+            return true;
         }
     }
 }
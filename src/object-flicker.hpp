@@ -45,19 +45,22 @@ namespace DropletCollection
                 inline Glib::RefPtr<Gdk::Pixbuf> get_image            () const;
                 inline void                      set_image            (const Glib::RefPtr<Gdk::Pixbuf>& image);
                 virtual void                     load                 (const SettingFile& file);
-                virtual void                     draw                 (const Cairo::RefPtr<Cairo::Context>& cr) const;
-                static bool                      collide_with_globule (const Flicker& self,
-                                                                       Globule&       other);
-                static bool                      collide_with_ball    (const Flicker& self,
-                                                                       Ball&          other);
+                virtual void                     draw                 (const Cairo::RefPtr<Cairo::Context>& cr,
+                                                                       double                               alpha) const;
+                static bool                      collide_with_globule (const Flicker&  self,
+                                                                       Globule&        other,
+                                                                       const Manifold& manifold);
+                static bool                      collide_with_ball    (const Flicker&  self,
+                                                                       Ball&           other,
+                                                                       const Manifold& manifold);
 
             private:
-                static const int          m_effect_count_max;
+                static const double       m_effect_duration;
                 static const double       m_effect_motion;
 
-                double                    m_speed;
+                double                    m_speed; //< [px/s]
                 Glib::RefPtr<Gdk::Pixbuf> m_image;
-                mutable int               m_effect_count;
+                mutable unsigned long     m_effect_tick; //< 衝突エフェクトを始めた tick (0 なら表示しない)
         };
 
         inline double
@@ -20,6 +20,7 @@
 #endif
 
 #include "error.hpp"
+#include "object-manager.hpp"
 #include "object-globule.hpp"
 #include "object-forcefield.hpp"
 
@@ -52,7 +53,9 @@ namespace DropletCollection
         {
             Circle::load(file);
 
-            m_force = file.get_double(get_name(), "Force", 0, 255);
+            // 1 tick あたりの速度加算量を，秒あたりの加速度に換算する
+            const double ref = get_reference_time_step();
+            m_force = file.get_double(get_name(), "Force", 0, 255) / (ref * ref);
 
             if( file.has_key(get_name(), "Image") )
             {
@@ -65,7 +68,8 @@ namespace DropletCollection
         }
 
         void
-        ForceField::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        ForceField::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                          const double                         alpha G_GNUC_UNUSED) const
         {
             dc_return_if_fail(m_image != 0);
             dc_return_if_fail(cr != 0);
@@ -76,19 +80,49 @@ namespace DropletCollection
             cr->paint();
         }
 
+        /**
+         * @brief ForceField は通り抜けられるので，連続衝突判定では止めない
+         */
+        bool
+        ForceField::sweep (const Globule&        other G_GNUC_UNUSED,
+                           const Vector<double>& start G_GNUC_UNUSED,
+                           const Vector<double>& motion G_GNUC_UNUSED,
+                           double&               toi G_GNUC_UNUSED) const
+        {
+            return false;
+        }
+
+        /**
+         * @brief 位置 @c position にある半径 @c radius の円が受ける加速度 [px/s^2] を求める
+         *
+         * @return 力の及ぶ範囲にあれば true を返し，@c force に加速度を格納する．
+         */
+        bool
+        ForceField::get_force_at (const Vector<double>& position,
+                                  const double          radius,
+                                  Vector<double>&       force) const
+        {
+            double distance = get_radius() + radius - get_position().distance(position);
+
+            if( ! fge(distance, 0.0) ) return false;
+
+            Vector<double> norm = (position - get_position()).get_unit();
+            double ratio = distance / (get_radius() + radius); // 距離の割合 (中心で 1，円周上で 0)
+
+            force = (m_force * ratio * ratio) * norm;
+            return true;
+        }
+
         bool
         ForceField::collide_with_globule (const ForceField& self,
                                           Globule&          other)
         {
-            double distance = self.get_distance(other);
+            Vector<double> force;
 
-            if( fge(distance, 0.0) )
+            if( self.get_force_at(other.get_position(), other.get_radius(), force) )
             {
-                Vector<double> norm = (other.get_position() - self.get_position()).get_unit();
-                double ratio = distance / (self.get_radius() + other.get_radius()); // 距離の割合 (中心で 1，円周上で 0)
-                double force = self.m_force * ratio * ratio;
-
-                other.set_velocity(other.get_velocity() + force * norm);
+                other.set_velocity(other.get_velocity() + force * self.get_manager().get_time_step());
+                other.wake(); // 力を受けている間は休眠させない
             }
 
             return false;
@@ -30,6 +30,8 @@ namespace DropletCollection
 {
     namespace Object
     {
+        class Globule;
+
         class ForceField : public Circle
         {
             public:
@@ -41,13 +43,21 @@ namespace DropletCollection
                 inline void                      set_force            (double force);
                 inline Glib::RefPtr<Gdk::Pixbuf> get_image            () const;
                 inline void                      set_image            (const Glib::RefPtr<Gdk::Pixbuf>& image);
+                bool                             get_force_at         (const Vector<double>& position,
+                                                                       double                radius,
+                                                                       Vector<double>&       force) const;
                 virtual void                     load                 (const SettingFile& file);
-                virtual void                     draw                 (const Cairo::RefPtr<Cairo::Context>& cr) const;
+                virtual void                     draw                 (const Cairo::RefPtr<Cairo::Context>& cr,
+                                                                       double                               alpha) const;
+                virtual bool                     sweep                (const Globule&        other,
+                                                                       const Vector<double>& start,
+                                                                       const Vector<double>& motion,
+                                                                       double&               toi) const;
                 static bool                      collide_with_globule (const ForceField& self,
                                                                        Globule&          other);
 
             private:
-                double                    m_force; // 中心点における速度加算量
+                double                    m_force; // 中心点における加速度 [px/s^2]
                 Glib::RefPtr<Gdk::Pixbuf> m_image;
         };
 
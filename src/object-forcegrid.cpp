@@ -0,0 +1,147 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cmath>
+#include "error.hpp"
+#include "object-forcefield.hpp"
+#include "object-forcegrid.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        bool ForceGrid::m_exact = false;
+
+        ForceGrid::ForceGrid ()
+            : m_radius_step(0.0),
+              m_inv_radius_step(0.0)
+        {
+        }
+
+        void
+        ForceGrid::clear ()
+        {
+            m_layers.clear();
+        }
+
+        bool
+        ForceGrid::empty () const
+        {
+            return m_layers.empty();
+        }
+
+        /**
+         * @brief 領域 @c region を間隔 @c cell_size で覆う格子に，@c fields による加速度の和を求める
+         *
+         *  半径は 0 から @c max_radius 以上になるまで @c radius_step 刻みで用意する．
+         */
+        void
+        ForceGrid::build (const BoundingBox&                     region,
+                          const double                           cell_size,
+                          const double                           radius_step,
+                          const double                           max_radius,
+                          const std::vector<const ForceField *>& fields)
+        {
+            const Vector<double> zero(0.0, 0.0);
+            Vector<double> force;
+            std::size_t i, j, k, l;
+
+            clear();
+
+            dc_return_if_fail(cell_size > 0.0);
+            dc_return_if_fail(radius_step > 0.0);
+
+            m_radius_step     = radius_step;
+            m_inv_radius_step = 1.0 / radius_step;
+            m_layers.resize(static_cast<std::size_t>(std::ceil(max_radius * m_inv_radius_step)) + 1);
+            if( m_layers.size() < 2 ) m_layers.resize(2);
+
+            for( k = 0; k < m_layers.size(); ++k )
+            {
+                SampleGrid<Vector<double> >& layer = m_layers[k];
+                const double radius = k * radius_step;
+
+                layer.reset(region, cell_size, zero);
+
+                for( j = 0; j < layer.get_n_rows(); ++j )
+                {
+                    for( i = 0; i < layer.get_n_columns(); ++i )
+                    {
+                        const Vector<double> point = layer.get_point(i, j);
+
+                        for( l = 0; l < fields.size(); ++l )
+                        {
+                            // 中心では力の向きが定まらないので，寄与させない
+                            if( point.distance2(fields[l]->get_position()) == 0.0 ) continue;
+
+                            if( fields[l]->get_force_at(point, radius, force) ) layer.add_value(i, j, force);
+                        }
+                    }
+                }
+            }
+
+            dc_log("ForceGrid: ForceField %lu 個, 格子 %lu x %lu x %lu (間隔 %g, 半径の刻み %g)",
+                   (unsigned long) fields.size(),
+                   (unsigned long) m_layers.front().get_n_columns(),
+                   (unsigned long) m_layers.front().get_n_rows(),
+                   (unsigned long) m_layers.size(),
+                   cell_size, radius_step);
+        }
+
+        /**
+         * @brief 位置 @c position にある半径 @c radius の円が受ける加速度を補間で求める
+         *
+         * @return 格子で扱えない円であれば false を返す．
+         */
+        bool
+        ForceGrid::sample (const Vector<double>& position,
+                           const double          radius,
+                           Vector<double>&       force) const
+        {
+            if( empty() || ! m_layers.front().contains(position) ) return false;
+
+            const double f = radius * m_inv_radius_step;
+            if( f < 0.0 || f > m_layers.size() - 1 ) return false; // 最大の半径を超えている
+
+            std::size_t k = static_cast<std::size_t>(f);
+            if( k > m_layers.size() - 2 ) k = m_layers.size() - 2;
+
+            const double t = f - k;
+            force = m_layers[k].sample(position) * (1.0 - t) + m_layers[k + 1].sample(position) * t;
+            return true;
+        }
+
+        /**
+         * @brief 格子を使わず，ForceField ごとに厳密に計算するかどうかを設定する (検証用)
+         */
+        void
+        ForceGrid::set_exact (const bool exact)
+        {
+            m_exact = exact;
+        }
+
+        bool
+        ForceGrid::get_exact ()
+        {
+            return m_exact;
+        }
+    }
+}
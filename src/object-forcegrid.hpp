@@ -0,0 +1,73 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_B7A2E4D1_0C58_4F93_9E6A_3D81F25C7B40
+#define INCLUDE_GUARD_B7A2E4D1_0C58_4F93_9E6A_3D81F25C7B40
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <vector>
+#include "boundingbox.hpp"
+#include "samplegrid.hpp"
+#include "vector.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        class ForceField;
+
+        /**
+         * @brief 全ての ForceField による加速度をまとめた格子
+         *
+         *  ForceField の力は受ける側の円の半径にも依存するので，半径 0, @c radius_step,
+         * 2 @c radius_step, ... ごとに領域全体の格子を作り，位置と半径について補間する．
+         * 格子の外にある円や，最大の半径より大きな円には使えない (sample() が false を返す)．
+         */
+        class ForceGrid
+        {
+            public:
+                ForceGrid ();
+
+                void        clear      ();
+                bool        empty      () const;
+                void        build      (const BoundingBox&                     region,
+                                        double                                 cell_size,
+                                        double                                 radius_step,
+                                        double                                 max_radius,
+                                        const std::vector<const ForceField *>& fields);
+                bool        sample     (const Vector<double>& position,
+                                        double                radius,
+                                        Vector<double>&       force) const;
+
+                static void set_exact  (bool exact);
+                static bool get_exact  ();
+
+            private:
+                std::vector<SampleGrid<Vector<double> > > m_layers; //< 半径ごとの格子
+                double                                    m_radius_step;
+                double                                    m_inv_radius_step;
+
+                static bool                               m_exact; //< 格子を使わず，常に厳密に計算する
+        };
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_B7A2E4D1_0C58_4F93_9E6A_3D81F25C7B40 */
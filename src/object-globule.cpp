@@ -27,33 +27,28 @@ namespace DropletCollection
     namespace Object
     {
         Globule::Globule (Manager& manager)
-            : Circle(manager, true),
-              m_velocity(0.0, 0.0),
-              m_rest(1.0),
-              m_weight(0.0)
+            : Circle(manager, true)
         {
+            set_restitution(1.0);
+            set_advanceable(false); // 時間発展は CircleStore::integrate() で行う
+
             if( register_class("Globule") )
             {
                 register_function("Globule",
-                                  (CollideFunc) &Globule::collide_with_globule);
+                                  (DetectFunc) &Circle::detect_circle,
+                                  (RespondFunc) &Globule::collide_with_globule);
             }
         }
 
         Globule::Globule (Manager&       manager,
                           const Globule& other)
-            : Circle(manager, other),
-              m_velocity(other.m_velocity),
-              m_rest(other.m_rest),
-              m_weight(other.m_weight)
-        {
-        }
-
-        void
-        Globule::advance ()
+            : Circle(manager, other)
         {
-            set_position(get_position() + m_velocity);
-
-            Circle::advance();
+            set_velocity(other.get_velocity());
+            set_restitution(other.get_restitution());
+            set_weight(other.get_weight());
+            set_visc_resist(other.get_visc_resist());
+            set_sleepable(other.get_sleepable());
         }
 
         void
@@ -65,34 +60,36 @@ namespace DropletCollection
             set_restitution(file.get_double(get_name(), "Restitution", 0, 1));
         }
 
+        /**
+         * @brief Globule 同士の衝突に応答する (接触は Circle::detect_circle() で検出する)
+         */
         bool
-        Globule::collide_with_globule (Globule& self,
-                                       Globule& other)
+        Globule::collide_with_globule (Globule&        self,
+                                       Globule&        other,
+                                       const Manifold& manifold)
         {
-            const double distance = self.get_distance(other);
+            const Vector<double>& norm = manifold.normal;
+            const double distance = manifold.distance;
+            Vector<double> va, vb;
+
+            decompose_velocity(self, other, norm, va, vb);
+            self.record_contact(other, -norm, distance);
 
-            if( fge(distance, 0.0) )
+            if( !self.is_collided(other) ) // まだ衝突してないなら，非弾性衝突をする
             {
-                Vector<double> norm, va, vb;
-                decompose_velocity(self, other, norm, va, vb);
-
-                if( !self.is_collided(other) ) // まだ衝突してないなら，非弾性衝突をする
-                {
-                    inelastic_collision(self, other, va, vb);
-                }
-                else // 食い込み修正用の擬似衝突規則
-                {
-                    if( fiszero(va.get_x()) ) va.set_x(distance * self.get_restitution());
-                    if( fiszero(vb.get_x()) ) vb.set_x(-distance * other.get_restitution());
-                }
-
-                self.set_velocity(norm.nob_compose(va));
-                other.set_velocity(norm.nob_compose(vb));
-
-                return true;
+                inelastic_collision(self, other, va, vb);
             }
+            else // 食い込み修正用の擬似衝突規則
+            {
+                const double rate = 1.0 / get_reference_time_step(); // 食い込みを 1 基準 tick で解消する
+                if( fiszero(va.get_x()) ) va.set_x(distance * rate * self.get_restitution());
+                if( fiszero(vb.get_x()) ) vb.set_x(-distance * rate * other.get_restitution());
+            }
+
+            self.set_velocity(norm.nob_compose(va));
+            other.set_velocity(norm.nob_compose(vb));
 
-            return false;
+            return true;
         }
 
         void
@@ -101,9 +98,9 @@ namespace DropletCollection
                                       Vector<double>& v_self,
                                       Vector<double>& v_other)
         {
-            const double e = (self.m_rest + other.m_rest) / 2.0; // 反発係数 (平均)
-            const double wa = self.m_weight  / (self.m_weight + other.m_weight); // 自分の質量比率
-            const double wb = other.m_weight / (self.m_weight + other.m_weight); // 相手の質量比率
+            const double e = (self.get_restitution() + other.get_restitution()) / 2.0; // 反発係数 (平均)
+            const double wa = self.get_weight()  / (self.get_weight() + other.get_weight()); // 自分の質量比率
+            const double wb = other.get_weight() / (self.get_weight() + other.get_weight()); // 相手の質量比率
 
             const double p  = wa * v_self.get_x() + wb * v_other.get_x(); // 系の運動量総和 (衝突方向)
             const double dv = e * (v_other.get_x() - v_self.get_x()); // 衝突後の速度の差分 (衝突方向)
@@ -112,14 +109,16 @@ namespace DropletCollection
             v_other.set_x(p - wa * dv);
         }
 
+        /**
+         * @brief 両者の速度を，法線 @c norm の方向とそれに垂直な方向の成分に分解する
+         */
         void
-        Globule::decompose_velocity (const Globule&  self,
-                                     const Globule&  other,
-                                     Vector<double>& norm,
-                                     Vector<double>& v_self,
-                                     Vector<double>& v_other)
+        Globule::decompose_velocity (const Globule&        self,
+                                     const Globule&        other,
+                                     const Vector<double>& norm,
+                                     Vector<double>&       v_self,
+                                     Vector<double>&       v_other)
         {
-            norm    = self.get_norm_from(other);
             v_self  = norm.nob_decompose(self.get_velocity());
             v_other = norm.nob_decompose(other.get_velocity());
         }
@@ -43,69 +43,118 @@ namespace DropletCollection
                 inline double         get_weight           () const;
                 inline void           set_weight           ();
                 inline void           set_weight           (double weight);
-                virtual void          advance              ();
+                inline bool           get_sleeping         () const;
+                inline void           wake                 ();
                 virtual void          load                 (const SettingFile& file);
-                static bool           collide_with_globule (Globule& self,
-                                                            Globule& other);
+                static bool           collide_with_globule (Globule&        self,
+                                                            Globule&        other,
+                                                            const Manifold& manifold);
 
             protected:
+                inline double get_visc_resist      () const;
+                inline void   set_visc_resist      (double visc_resist);
+                inline bool   get_sleepable        () const;
+                inline void   set_sleepable        (bool sleepable);
                 static void   inelastic_collision  (Globule&        self,
                                                     Globule&        other,
                                                     Vector<double>& v_self,
                                                     Vector<double>& v_other);
-                static void   decompose_velocity   (const Globule&  self,
-                                                    const Globule&  other,
-                                                    Vector<double>& norm,
-                                                    Vector<double>& v_self,
-                                                    Vector<double>& v_other);
-
-
-            private:
-                Vector<double> m_velocity;
-                double         m_rest;
-                double         m_weight;
+                static void   decompose_velocity   (const Globule&        self,
+                                                    const Globule&        other,
+                                                    const Vector<double>& norm,
+                                                    Vector<double>&       v_self,
+                                                    Vector<double>&       v_other);
         };
 
+        // 速度などの状態は CircleStore に置かれ，時間発展も CircleStore::integrate() で行う
+
         inline Vector<double>
         Globule::get_velocity () const
         {
-            return m_velocity;
+            return Vector<double>(get_store().m_vx[get_slot()], get_store().m_vy[get_slot()]);
         }
 
         inline void
         Globule::set_velocity (const Vector<double>& v)
         {
-            m_velocity = v;
+            get_store().m_vx[get_slot()] = v.get_x();
+            get_store().m_vy[get_slot()] = v.get_y();
         }
 
         inline double
         Globule::get_restitution () const
         {
-            return m_rest;
+            return get_store().m_rest[get_slot()];
         }
 
         inline void
         Globule::set_restitution (const double rest)
         {
-            m_rest = rest;
+            get_store().m_rest[get_slot()] = rest;
         }
 
         inline double
         Globule::get_weight () const
         {
-            return m_weight;
+            return get_store().m_weight[get_slot()];
         }
 
         inline void
         Globule::set_weight ()
         {
-            m_weight = get_radius() * get_radius();
+            set_weight(get_radius() * get_radius());
         }
 
         inline void
         Globule::set_weight (double weight)
         {
-            m_weight = weight;
+            get_store().m_weight[get_slot()] = weight;
+        }
+
+        /**
+         * @brief 休眠している (静止しているので衝突計算を省いている) かどうか
+         */
+        inline bool
+        Globule::get_sleeping () const
+        {
+            return get_store().is_sleeping(get_slot());
+        }
+
+        inline void
+        Globule::wake ()
+        {
+            get_store().wake(get_slot());
+        }
+
+        inline double
+        Globule::get_visc_resist () const
+        {
+            return get_store().m_visc_resist[get_slot()];
+        }
+
+        /**
+         * @brief 粘性抵抗の係数を設定する (毎 tick 速度に 係数 * 半径 * 時間刻み を掛けた分だけ減衰する)
+         */
+        inline void
+        Globule::set_visc_resist (const double visc_resist)
+        {
+            get_store().m_visc_resist[get_slot()] = visc_resist;
+        }
+
+        inline bool
+        Globule::get_sleepable () const
+        {
+            return get_store().m_sleepable[get_slot()] != 0;
+        }
+
+        /**
+         * @brief 静止し続けたときに休眠させてよいかどうかを設定する
+         */
+        inline void
+        Globule::set_sleepable (const bool sleepable)
+        {
+            get_store().m_sleepable[get_slot()] = sleepable;
+            if( ! sleepable ) wake();
         }
     }
 }
@@ -19,6 +19,9 @@
 #  include "config.h"
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include "error.hpp"
 #include "object-objectbase.hpp"
 #include "object-field.hpp"
@@ -35,16 +38,116 @@ namespace DropletCollection
 {
     namespace Object
     {
+        namespace
+        {
+            // 物体が Circle であれば CircleStore 上のスロットを，そうでなければ NO_SLOT を返す
+            std::size_t
+            get_circle_slot (const ObjectBase& object)
+            {
+                static const ObjectBase::ClassId circle_class = ObjectBase::intern_class("Circle");
+
+                if( ! object.is(circle_class) ) return CircleStore::NO_SLOT;
+
+                return static_cast<const Circle&>(object).get_slot();
+            }
+
+            // Union-Find の要素 @c i の根を返す (経路を半分に縮める)
+            std::size_t
+            find_root (std::vector<std::size_t>& parent,
+                       std::size_t               i)
+            {
+                while( parent[i] != i )
+                {
+                    parent[i] = parent[parent[i]];
+                    i = parent[i];
+                }
+
+                return i;
+            }
+
+            // WorkerPool に T のメンバ関数を処理として渡す
+            template <class T>
+            class MemberJob : public WorkerPool::Job
+            {
+                public:
+                    typedef void (T::*Func) (std::size_t  index,
+                                             unsigned int worker);
+
+                    MemberJob (T&   object,
+                               Func func)
+                        : m_object(object),
+                          m_func(func)
+                    {
+                    }
+
+                    virtual void
+                    execute (const std::size_t  index,
+                             const unsigned int worker)
+                    {
+                        (m_object.*m_func)(index, worker);
+                    }
+
+                private:
+                    T&   m_object;
+                    Func m_func;
+            };
+        }
+
+        const std::size_t   Manager::NO_ISLAND;
+        const std::size_t   Manager::NO_PAIR;
+        const unsigned long Manager::NO_WAKE;
+
+        // 衝突判定 (fge) の許容誤差に丸め誤差の余裕を加えたもの
+        const double       Manager::m_broadphase_margin = 2.0 * OC_FMIN;
+        // 連続衝突判定で止めた Ball を，離散的な衝突判定が接触とみなすように食い込ませる距離 [px]
+        const double       Manager::m_sweep_slop = 1e-3;
+        bool               Manager::m_sweep_enabled = true;
+        // 高速な物体が分割した 1 回の移動で進んでよい距離 (半径に対する比) と，1 tick の分割数の上限
+        const double       Manager::m_substep_length = 1.0;
+        const unsigned int Manager::m_max_substeps = 8;
+        bool               Manager::m_substep_enabled = true;
+        // ENGINE_EVENT で，待機させる物体が動いてよい距離の上限 [px] と，待機させる tick 数の上限・下限
+        // (短い待機は，時間発展を再開する手間に見合わない)
+        const double        Manager::m_park_reach = 32.0;
+        const unsigned long Manager::m_max_park_ticks = 64;
+        const unsigned long Manager::m_min_park_ticks = 4;
+        // 待機させられなかった物体を調べ直すまでの tick 数の上限
+        const unsigned long Manager::m_max_park_backoff = 16;
+        // 待機させる物体の移動量の見積もりに加える，丸め誤差の余裕 [px]
+        const double        Manager::m_park_slop = 1e-6;
+        bool               Manager::m_engine_forced = false;
+        Manager::Engine    Manager::m_forced_engine = Manager::ENGINE_TICK;
+        unsigned int       Manager::m_n_threads = 1;
+        bool               Manager::m_island_enabled = false;
+
         Manager::Manager (const std::string& filename)
             : m_state(STATE_STAND_BY),
+              m_engine(ENGINE_TICK),
+              m_tick(0),
+              m_time_step(ObjectBase::get_reference_time_step()),
               m_field(0),
               m_racket(0),
               m_ball(0),
               m_image_gameover(0),
-              m_image_gameclear(0)
+              m_image_gameclear(0),
+              m_next_id(0),
+              m_n_reclaimed(0),
+              m_n_unmerged_groups(0),
+              m_n_hashed(0),
+              m_touched_rehashed(false),
+              m_n_parked(0),
+              m_parked_speed(0.0),
+              m_park_dt(0.0),
+              m_collision_tick(0),
+              m_resolving_islands(false),
+              m_fixed_tree_valid(false),
+              m_force_reach(0.0)
         {
             m_file.load_from_file(filename);
 
+            m_workers.resize(m_n_threads);
+            m_detect_buffers.resize(m_workers.size());
+
             m_image_gameover = Gdk::Pixbuf::create_from_file(
                 Glib::build_filename(DC_DATADIR, "image/gameover.png")
             );
@@ -99,14 +202,56 @@ namespace DropletCollection
             m_state = STATE_PLAYING;
         }
 
+        /**
+         * @brief 物体とオブジェクト ID の使用状況を返す
+         */
+        Manager::Statistics
+        Manager::get_statistics () const
+        {
+            Statistics stat;
+
+            stat.n_fixed      = m_fixed_objects.size();
+            stat.n_movable    = m_movable_objects.size();
+            stat.n_pooled_ids = m_free_ids.size() + m_released_ids[0].size() + m_released_ids[1].size();
+            stat.n_ids        = m_next_id - stat.n_pooled_ids;
+            stat.n_reclaimed  = m_n_reclaimed;
+            stat.n_chunks     = m_object_pool.get_n_chunks();
+            stat.n_sleeping   = 0;
+            for( std::size_t i = 0; i < m_circle_store.get_n_active(); ++i )
+            {
+                if( m_circle_store.is_sleeping(i) ) ++stat.n_sleeping;
+            }
+
+            return stat;
+        }
+
         void
         Manager::attach_internal (ObjectBase * const object)
         {
+            static const ObjectBase::ClassId globule_class = ObjectBase::intern_class("Globule");
+            static const ObjectBase::ClassId droplet_class = ObjectBase::intern_class("Droplet");
+
             dc_return_if_fail(object != 0);
 
+            if( object->get_id() >= m_slots.size() )
+            {
+                const Slot empty = {0, 0};
+                m_slots.resize(object->get_id() + 1, empty);
+            }
+            m_slots[object->get_id()].object = object;
+
+            // 登録された Globule は CircleStore::integrate() で時間を進める
+            if( object->is(globule_class) )
+            {
+                m_circle_store.activate(static_cast<Circle *>(object)->get_slot());
+            }
+
             if( object->get_movable() )
             {
-                m_movable_list.push_back(object);
+                if( object->is(droplet_class) ) add_to_group(static_cast<Droplet *>(object)->get_group_id());
+
+                m_movable_objects.push_back(object);
+                if( object->get_advanceable() ) m_advanceable_objects.push_back(object);
 
                 dc_log("movable 集合へ '%s' (クラス '%s') を追加しました",
                        object->get_name().c_str(),
@@ -114,7 +259,8 @@ namespace DropletCollection
             }
             else
             {
-                m_fixed_list.push_back(object);
+                m_fixed_objects.push_back(object);
+                m_fixed_tree_valid = false; // AABB 木を作り直す
 
                 dc_log("fixed 集合へ '%s' (クラス '%s') を追加しました",
                        object->get_name().c_str(),
@@ -122,27 +268,74 @@ namespace DropletCollection
             }
         }
 
-        bool
-        Manager::exists (const ObjectBase& object) const
+        /**
+         * @brief 新しいオブジェクト ID を割り当てる
+         *
+         *  解放済みの ID があればそれを再利用する．割り当てられる ID の数に上限はない．
+         */
+        unsigned int
+        Manager::allocate_object_id ()
         {
-            std::list<ObjectBase *>::const_iterator it;
+            if( m_free_ids.empty() ) return m_next_id++;
 
-            if( object.get_movable() )
-            {
-                // movable 物体集合を検索する
-                for( it = m_movable_list.begin(); it != m_movable_list.end(); ++it )
-                    if( *it == &object )
-                        return true;
-            }
-            else
+            const unsigned int id = m_free_ids.back();
+            m_free_ids.pop_back();
+            return id;
+        }
+
+        /**
+         * @brief オブジェクト ID を解放する
+         *
+         *  直前・現在の tick の衝突の記録に ID が残っている可能性があるので，2 tick 経過して
+         * から再利用する．ID に対応するハンドルはこの時点で無効になる．
+         */
+        void
+        Manager::release_object_id (const unsigned int id)
+        {
+            if( id < m_slots.size() )
             {
-                // fixed 物体集合を検索する
-                for( it = m_fixed_list.begin(); it != m_fixed_list.end(); ++it )
-                    if( *it == &object )
-                        return true;
+                m_slots[id].object = 0;
+                ++m_slots[id].generation;
             }
 
-            return false;
+            m_released_ids[0].push_back(id);
+        }
+
+        Manager::Handle
+        Manager::get_handle (const ObjectBase& object) const
+        {
+            const unsigned int id = object.get_id();
+            Handle handle = {id, 0};
+
+            if( id < m_slots.size() ) handle.generation = m_slots[id].generation;
+
+            return handle;
+        }
+
+        /**
+         * @brief ハンドルが指す物体を返す (既に破棄されていれば 0 を返す)
+         */
+        ObjectBase *
+        Manager::lookup (const Handle& handle) const
+        {
+            if( handle.id >= m_slots.size() ) return 0;
+            if( m_slots[handle.id].generation != handle.generation ) return 0;
+
+            return m_slots[handle.id].object;
+        }
+
+        bool
+        Manager::exists (const Handle& handle) const
+        {
+            return lookup(handle) != 0;
+        }
+
+        bool
+        Manager::exists (const ObjectBase& object) const
+        {
+            const unsigned int id = object.get_id();
+
+            return id < m_slots.size() && m_slots[id].object == &object;
         }
 
         /**
@@ -151,16 +344,44 @@ namespace DropletCollection
         void
         Manager::clear ()
         {
-            std::list<ObjectBase *>::iterator it;
+            std::size_t i;
+            const Statistics stat = get_statistics();
+
+            dc_log("物体を破棄します (fixed %lu, movable %lu, ID 割り当て中 %lu, ID 再利用待ち %lu, 回収済み %lu, チャンク %lu)",
+                   (unsigned long) stat.n_fixed, (unsigned long) stat.n_movable,
+                   (unsigned long) stat.n_ids, (unsigned long) stat.n_pooled_ids,
+                   (unsigned long) stat.n_reclaimed, (unsigned long) stat.n_chunks);
 
             // fixed 物体の削除
-            for( it = m_fixed_list.begin(); it != m_fixed_list.end(); ++it ) delete (*it);
+            for( i = 0; i < m_fixed_objects.size(); ++i ) delete m_fixed_objects[i];
 
             // movable 物体の削除
-            for( it = m_movable_list.begin(); it != m_movable_list.end(); ++it ) delete (*it);
+            for( i = 0; i < m_movable_objects.size(); ++i ) delete m_movable_objects[i];
 
-            m_fixed_list.clear();
-            m_movable_list.clear();
+            m_fixed_objects.clear();
+            m_movable_objects.clear();
+            m_advanceable_objects.clear();
+            m_group_sizes.clear();
+            m_n_unmerged_groups = 0;
+            m_object_pool.reset(); // 全ての物体を破棄したので，プールを先頭から使い直す
+            m_fixed_unbounded.clear();
+            m_fixed_tree.clear();
+            m_fixed_tree_valid = false;
+            m_force_grid.clear();
+            m_force_fields.clear();
+            m_force_reach = 0.0;
+            m_parked.clear();
+            m_wake_events.clear();
+            m_n_parked = 0;
+            m_parked_speed = 0.0;
+
+            // 衝突の記録が空になったので，解放した ID はすぐに再利用できる
+            m_contacts.clear();
+            for( i = 0; i < 2; ++i )
+            {
+                m_free_ids.insert(m_free_ids.end(), m_released_ids[i].begin(), m_released_ids[i].end());
+                m_released_ids[i].clear();
+            }
 
             m_field = 0;
             m_racket = 0;
@@ -176,6 +397,19 @@ namespace DropletCollection
             clear(); // 現在登録されている全ての要素を削除する
             m_state = STATE_STAND_BY; // 初期状態に戻す
 
+            // 移動と衝突判定の方式を決める (コマンドラインでの指定をステージ設定ファイルより優先する)
+            m_engine = ENGINE_TICK;
+            if( m_engine_forced )
+            {
+                m_engine = m_forced_engine;
+            }
+            else if( m_file.has_key("Field", "Engine") && ! parse_engine(m_file.get_string("Field", "Engine"), m_engine) )
+            {
+                throw Glib::KeyFileError(Glib::KeyFileError::INVALID_VALUE,
+                                         "方式 '" + m_file.get_string("Field", "Engine") + "' は定義されていません");
+            }
+            dc_log("移動と衝突判定に '%s' 方式を使用します", get_engine_name(m_engine));
+
             // フィールドを構築する
             m_field = attach<Field>();
             m_field->set_name("Field");
@@ -207,6 +441,12 @@ namespace DropletCollection
                     initialize_optional_object(class_name, *it);
                 }
             }
+
+            build_force_grid();
+            build_fixed_tree(); // fixed 物体はこれ以降動かない
+
+            // 待機させた物体の動き得る範囲は，m_park_reach だけ広げた矩形になる
+            m_parked_hash.reset(m_field->get_region(), 2.0 * m_park_reach);
         }
 
         void
@@ -250,54 +490,72 @@ namespace DropletCollection
             }
         }
 
+        /**
+         * @brief 時間を @c dt [s] だけ進める (1 tick)
+         */
         void
-        Manager::simulate ()
+        Manager::simulate (const double dt)
         {
-            std::list<ObjectBase *>::iterator it, vit;
+            static const ObjectBase::ClassId droplet_class = ObjectBase::intern_class("Droplet");
+            std::size_t i, n;
+
+            dc_return_if_fail(dt > 0.0);
+
+            begin_tick(dt);
+
+            const Vector<double> ball_start = m_ball != 0 ? m_ball->get_position() : Vector<double>(0.0, 0.0);
 
             // 各物体の時間を進める
-            for( it = m_fixed_list.begin(); it != m_fixed_list.end(); ++it ) (*it)->advance();
-            for( it = m_movable_list.begin(); it != m_movable_list.end(); ++it ) (*it)->advance();
+            for( i = 0; i < m_fixed_objects.size(); ++i ) m_fixed_objects[i]->advance(dt);
+            for( i = 0; i < m_advanceable_objects.size(); ++i ) m_advanceable_objects[i]->advance(dt);
+            if( m_n_parked > 0 ) wake_due_objects(); // 待機を終える予定の tick に達した物体
+            m_circle_store.integrate(dt); // Globule の速度の減衰と移動はまとめて行う
+
+            // 半径に比べて速い物体は，tick を分割した最初の 1 回分だけ進めておく
+            plan_substeps(dt);
+
+            // 高速な Ball は，移動の途中で最初に衝突する位置で止める (連続衝突判定)
+            if( m_ball != 0 && m_sweep_enabled ) sweep_ball(ball_start, dt / count_substeps(*m_ball, dt));
 
             // movable-movable 間の衝突計算を行う
-            for( it = m_movable_list.begin(); it != m_movable_list.end(); ++it )
-            {
-                if( (*it)->get_alive() )
-                {
-                    for( vit = it, ++vit; vit != m_movable_list.end(); ++vit )
-                    {
-                        if( (*vit)->get_alive() )
-                        {
-                            (*it)->collide(*(*vit));
-                        }
-                    }
-                }
-            }
+            collide_movable_objects();
 
             // fixed-movable 間の衝突計算を行う
-            for( it = m_movable_list.begin(); it != m_movable_list.end(); ++it )
+            collide_fixed_objects();
+
+            // 高速な物体だけ，tick の残りを分割して進めながら周囲の物体との衝突計算を行う
+            run_substeps(dt);
+
+            // 静止し続けている Globule を休眠させる
+            m_circle_store.update_sleep(dt);
+
+            // 不要になった movable 物体を削除する (生存している物体の順序は保つ)
+            for( i = 0, n = 0; i < m_advanceable_objects.size(); ++i )
             {
-                if( (*it)->get_alive() )
-                {
-                    for( vit = m_fixed_list.begin(); vit != m_fixed_list.end(); ++vit )
-                    {
-                        (*it)->collide(*(*vit));
-                    }
-                }
+                if( m_advanceable_objects[i]->get_alive() ) m_advanceable_objects[n++] = m_advanceable_objects[i];
             }
+            m_advanceable_objects.resize(n);
 
-            // 不要になった movable 物体を削除する
-            for( it = m_movable_list.begin(); it != m_movable_list.end(); )
+            for( i = 0, n = 0; i < m_movable_objects.size(); ++i )
             {
-                if( (*it)->get_alive() ) // オブジェクトが生存していれば，何もしない
+                ObjectBase * const object = m_movable_objects[i];
+
+                if( object->get_alive() ) // オブジェクトが生存していれば，詰めて残す
                 {
-                    ++it;
+                    if( n != i && is_parked(i) ) m_parked[object->get_id()].index = n;
+                    m_movable_objects[n++] = object;
                 }
                 else // オブジェクトが死亡している
                 {
-                    it = m_movable_list.erase(it); // オブジェクトを削除する
+                    if( object->is(droplet_class) ) remove_from_group(static_cast<Droplet *>(object)->get_group_id());
+
+                    // 衝突計算は終わっているので，他の物体から参照されることはない．
+                    // オブジェクト ID はデストラクタで解放される．
+                    delete object;
+                    ++m_n_reclaimed;
                 }
             }
+            m_movable_objects.resize(n);
 
             // ゲームクリアの処理
             if( m_state == STATE_PLAYING && check_gameclear() ) // 各 ID の Droplet が全て集まった
@@ -305,53 +563,2146 @@ namespace DropletCollection
                 m_state = STATE_GAMECLEAR;
 
                 // ボールを削除する
-                for( it = m_movable_list.begin(); it != m_movable_list.end(); ++it )
+                std::vector<ObjectBase *>::iterator it = std::find(m_movable_objects.begin(),
+                                                                   m_movable_objects.end(),
+                                                                   static_cast<ObjectBase *>(m_ball));
+                if( it != m_movable_objects.end() )
                 {
-                    if( *it == m_ball )
+                    const std::size_t index = it - m_movable_objects.begin();
+
+                    m_movable_objects.erase(it); // オブジェクトを削除する
+                    m_advanceable_objects.erase(std::remove(m_advanceable_objects.begin(),
+                                                            m_advanceable_objects.end(),
+                                                            static_cast<ObjectBase *>(m_ball)),
+                                                m_advanceable_objects.end());
+                    delete m_ball; m_ball = 0;
+
+                    // 後ろの物体の添字がずれる
+                    for( i = index; i < m_movable_objects.size(); ++i )
                     {
-                        m_movable_list.erase(it); // オブジェクトを削除する
-                        delete m_ball; m_ball = 0;
-                        break;
+                        if( is_parked(i) ) m_parked[m_movable_objects[i]->get_id()].index = i;
                     }
                 }
 
                 dc_log("ユーザはゲームをクリアしました");
             }
+
+            // しばらく何とも衝突しない物体は，次に衝突し得る tick まで待機させる
+            if( m_engine == ENGINE_EVENT ) park_objects();
         }
 
-        bool
-        Manager::check_gameclear () const
+        /**
+         * @brief 時間を @c dt [s] ずつ @c n_ticks tick 進める
+         *
+         *  simulate() を @c n_ticks 回呼び出すのと同じ結果になる．ENGINE_EVENT で全ての movable
+         * 物体が待機していれば，最も早く待機を終える tick の直前までは，tick 数と衝突の記録を
+         * 進め，fixed 物体の時間を進めるだけで済ませる．
+         */
+        void
+        Manager::fast_forward (const double  dt,
+                               unsigned long n_ticks)
+        {
+            dc_return_if_fail(dt > 0.0);
+
+            while( n_ticks > 0 )
+            {
+                unsigned long n_skipped = 0;
+
+                if( m_engine == ENGINE_EVENT && m_n_parked == m_movable_objects.size() &&
+                    m_advanceable_objects.empty() && dt == m_park_dt )
+                {
+                    // 待機している物体が既に起きていれば，その予定は古い
+                    while( ! m_wake_events.empty() )
+                    {
+                        const WakeEvent& event = m_wake_events.front();
+
+                        if( m_parked[event.id].parked && m_parked[event.id].stamp == event.stamp ) break;
+
+                        std::pop_heap(m_wake_events.begin(), m_wake_events.end(), is_later_wake);
+                        m_wake_events.pop_back();
+                    }
+
+                    n_skipped = n_ticks;
+                    if( ! m_wake_events.empty() ) n_skipped = std::min(n_skipped, m_wake_events.front().tick - 1 - m_tick);
+                }
+
+                if( n_skipped == 0 )
+                {
+                    simulate(dt);
+                    --n_ticks;
+                    continue;
+                }
+
+                for( n_ticks -= n_skipped; n_skipped > 0; --n_skipped )
+                {
+                    begin_tick(dt);
+                    for( std::size_t i = 0; i < m_fixed_objects.size(); ++i ) m_fixed_objects[i]->advance(dt);
+                }
+            }
+        }
+
+        /**
+         * @brief tick を 1 つ進め，前の tick の状態の保存と衝突の記録の切り替えを行う
+         *
+         *  simulate() と fast_forward() の初めに行う共通の処理である．時間刻みが変わったときは，
+         * 待機している物体を全てそれまでの時間刻みで進めてから，時間発展を再開する．
+         */
+        void
+        Manager::begin_tick (const double dt)
+        {
+            ++m_tick;
+            m_time_step = dt;
+            if( m_n_parked > 0 && dt != m_park_dt ) wake_all_parked(false);
+            m_park_dt = dt;
+            m_circle_store.save_state(); // 描画時の補間のために，前の tick の状態を残しておく
+
+            // 衝突の記録を次の tick へ切り替える
+            m_contacts.rotate();
+            m_free_ids.insert(m_free_ids.end(), m_released_ids[1].begin(), m_released_ids[1].end());
+            m_released_ids[1].swap(m_released_ids[0]);
+            m_released_ids[0].clear();
+        }
+
+        /**
+         * @brief movable 物体同士の衝突を計算する
+         *
+         *  空間ハッシュで衝突し得る組に絞り込んでから ObjectBase::collide を呼び出す．
+         * 呼び出しの順序は全ての組を総当りする場合と同じ (m_movable_objects の順で i < j となる組
+         * (i, j) を辞書式順序で) なので，計算結果も総当りの場合と一致する．
+         *
+         *  衝突によって物体の位置・大きさが変化したり (Droplet の合成)，新しい物体が追加された
+         * りする (Splitter の分裂) ことがある．そのような物体は空間ハッシュの情報が古くなって
+         * いるので，常に候補に含める．追加された物体は m_movable_objects の末尾に置かれるので，
+         * 計算中も既存の物体の添字は変わらない．
+         *
+         *  休眠している物体は自分からは衝突し得る物体を探さず，起きている物体の側で
+         * 添字の大小によらず候補に含める．休眠している物体同士の組は調べない．
+         * 呼び出しは常に添字の小さい物体を基準に行う．
+         *
+         *  衝突し得る組の検出はワーカーで分担し，衝突は添字の順に計算するので，結果はスレッド数
+         * によらない．set_island_enabled() で有効にした場合は，衝突し得る組でつながった物体の
+         * 集まり (島) ごとに分担して計算する (resolve_islands())．
+         *
+         *  待機している物体 (ENGINE_EVENT) は空間ハッシュに登録しない．起きている物体と衝突し得る
+         * ものは，構築の直後に時間発展を再開させて登録する (wake_parked_neighbours())．
+         * 計算中に位置・大きさが変化した物体や追加された物体と衝突し得るものも，その時点で
+         * 再開させる (mark_moved_object(), register_added_objects())．
+         */
+        void
+        Manager::collide_movable_objects ()
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            BoundingBox box;
+            double cell_size = 0.0;
+            std::size_t i;
+
+            if( objects.empty() ) return;
+
+            m_n_hashed = objects.size();
+            m_collision_touched.clear();
+            m_collision_touched_flags.assign(objects.size(), false);
+
+            // 衝突計算中に時間発展させる領域のスロットが動くことはない
+            m_collision_slots.resize(objects.size());
+            m_collision_asleep.resize(objects.size());
+            for( i = 0; i < objects.size(); ++i )
+            {
+                m_collision_slots[i]  = get_circle_slot(*objects[i]);
+                m_collision_asleep[i] = m_collision_slots[i] != CircleStore::NO_SLOT &&
+                                        m_circle_store.is_sleeping(m_collision_slots[i]);
+            }
+
+            // 空間ハッシュを構築する (セルの大きさは最大の物体に合わせる)
+            for( i = 0; i < objects.size(); ++i )
+            {
+                if( ! is_parked(i) && objects[i]->get_bounding_box(box) )
+                {
+                    cell_size = std::max(cell_size, box.get_width());
+                    cell_size = std::max(cell_size, box.get_height());
+                }
+            }
+            m_spatial_hash.reset(m_field ? m_field->get_region() : BoundingBox(), cell_size);
+            for( i = 0; i < objects.size(); ++i )
+            {
+                if( is_parked(i) ) continue;
+
+                if( objects[i]->get_bounding_box(box) ) m_spatial_hash.insert(i, box);
+                else                                    m_spatial_hash.insert(i);
+            }
+            m_collision_tick = m_tick; // これ以降に時間発展を再開した物体は，その時点で登録する
+
+            // 待機している物体のうち，起きている物体と衝突し得るものの時間発展を再開する
+            if( m_n_parked > 0 ) wake_parked_neighbours();
+
+            // 衝突し得る組をワーカーで分担して検出してから，添字の順に衝突を計算する
+            detect_pairs(false);
+
+            if( uses_islands() )
+            {
+                resolve_islands();
+                return;
+            }
+
+            for( i = 0; i < objects.size(); ++i )
+            {
+                if( ! objects[i]->get_alive() || was_asleep(i) || is_parked(i) ) continue;
+
+                collide_movable_object(i, false, m_detect_buffers[0]);
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c index と，衝突し得る movable 物体との衝突を計算する
+         *
+         *  collide_movable_objects() で構築した空間ハッシュを使う．@c substep が false なら
+         * collide_movable_objects() の一部として，添字の小さい物体は休眠していたものだけを調べる．
+         * このとき衝突し得る組は detect_pairs() で検出したものを使う．
+         * true なら tick の分割した移動 (run_substeps()) の後で，全ての物体を調べ直す．
+         * @c buffer は計算を行うワーカーの領域である．
+         */
+        void
+        Manager::collide_movable_object (const std::size_t index,
+                                         const bool        substep,
+                                         DetectBuffer&     buffer)
         {
-            std::list<ObjectBase *>::const_iterator it, vit;
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            std::vector<std::size_t>& candidates = buffer.targets;
+            bool detected = false; // 候補が検出した組で，buffer.target_pairs を使える
+            std::size_t k;
+
+            if( ! substep && index < m_detections.size() && m_detections[index].valid && ! m_detect_changed_flags[index] )
+            {
+                take_detected_candidates(index, candidates, buffer);
+                detected = true;
+            }
+            else
+            {
+                find_collision_candidates(index, 0, substep, candidates, buffer);
+            }
 
-            for( it = m_movable_list.begin(); it != m_movable_list.end(); ++it )
+            for( k = 0; k < candidates.size() && objects[index]->get_alive(); ++k )
             {
-                if( ! (*it)->is("Droplet") ) continue; // Droplet でないなら，チェックは不要
-                const Droplet *p1 = static_cast<const Droplet *>(*it);
+                const std::size_t j = candidates[k];
+                BoundingBox box_i, box_j;
+                bool moved = false, moved_j = false;
+
+                if( ! objects[j]->get_alive() ) continue;
+
+                // 分割した移動では，衝突計算の開始後に起きた物体を休眠しているものとして扱わない
+                const bool asleep_j = substep ? m_collision_slots[j] != CircleStore::NO_SLOT &&
+                                                m_circle_store.is_sleeping(m_collision_slots[j])
+                                              : was_asleep(j);
+
+                objects[index]->get_bounding_box(box_i);
+                objects[j]->get_bounding_box(box_j);
+                if( ! collide_movable_pair(index, j, detected ? buffer.target_pairs[k] : NO_PAIR) ) continue;
+
+                // 衝突によって位置・大きさが変化した物体を記録する (Droplet の合成など)
+                moved   = mark_moved_object(index, box_i, buffer);
+                moved_j = mark_moved_object(j, box_j, buffer);
+                if( ! substep )
+                {
+                    mark_changed_object(index, buffer);
+                    mark_changed_object(j, buffer);
+                }
+
+                // 休眠している物体は，動かされたときだけ起こす
+                if( asleep_j && objects[j]->get_alive() ) m_circle_store.disturb(m_collision_slots[j], moved_j);
+
+                // 衝突によって物体が追加された
+                if( register_added_objects(index) ) moved = true;
 
-                for( vit = it, ++vit; vit != m_movable_list.end(); ++vit )
+                if( moved ) // j より後ろの候補を探し直す
                 {
-                    if( ! (*vit)->is("Droplet") ) continue; // Droplet でないなら，チェックは不要
-                    const Droplet *p2 = static_cast<const Droplet *>(*vit);
+                    find_collision_candidates(index, j + 1, substep, candidates, buffer);
+                    detected = false;
+                    k = static_cast<std::size_t>(-1);
+                }
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c index と @c other の衝突を，添字の小さい物体を基準に計算する
+         *
+         *  @c pair は detect_pairs() で検出した組の位置である．両者の状態が検出した時点から
+         * 変化していなければ，検出の際に求めた接触の情報を使って応答だけを行う (結果は
+         * ObjectBase::collide() と変わらない)．NO_PAIR なら現在の状態で判定する．
+         *
+         * @return 衝突していれば true を返す．
+         */
+        bool
+        Manager::collide_movable_pair (const std::size_t index,
+                                       const std::size_t other,
+                                       const std::size_t pair)
+        {
+            ObjectBase& self = *m_movable_objects[std::min(index, other)];
+            ObjectBase& target = *m_movable_objects[std::max(index, other)];
 
-                    // 同じグループIDの droplet が存在するなら，まだゲームはクリアしていない
-                    if( p1->get_group_id() == p2->get_group_id() ) return false;
+            if( pair != NO_PAIR && ! m_detect_changed_flags[index] && ! m_detect_changed_flags[other] )
+            {
+                const DetectBuffer& source = m_detect_buffers[m_detections[index].worker];
+
+                switch( source.contacts[pair] )
+                {
+                    case ObjectBase::DETECT_SEPARATED:
+                        return false;
+                    case ObjectBase::DETECT_TOUCHING:
+                        return self.respond(target, source.manifolds[pair]);
+                    default: // 規則が判定と応答に分かれていない
+                        break;
                 }
             }
 
+            return self.collide(target);
+        }
+
+        /**
+         * @brief 衝突計算中に追加された movable 物体 (Splitter の分裂など) を，
+         *        空間ハッシュの情報が古くなった物体として扱えるようにする
+         *
+         *  島ごとの衝突の計算中なら，追加された物体は衝突した物体 @c index と同じ島に属する．
+         * 追加された Globule を時間発展させる領域へ移すと fixed 物体のスロットが入れ替わり得るので，
+         * m_fixed_slots も取得し直す (tick の分割した移動では，この後に fixed 物体との衝突を計算する)．
+         * 追加された物体と衝突し得る待機している物体は，時間発展を再開させる．
+         *
+         * @return 物体が追加されていれば true を返す．
+         */
+        bool
+        Manager::register_added_objects (const std::size_t index)
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            const std::size_t n_objects = m_collision_touched_flags.size();
+            BoundingBox box;
+            std::size_t l;
+
+            if( n_objects >= objects.size() ) return false;
+
+            for( l = m_collision_slots.size(); l < objects.size(); ++l )
+            {
+                m_collision_slots.push_back(get_circle_slot(*objects[l]));
+            }
+            m_collision_touched_flags.resize(objects.size(), false);
+            update_fixed_slots();
+            if( ! m_island_ids.empty() ) m_island_ids.resize(objects.size(), m_resolving_islands ? m_island_ids[index] : NO_ISLAND);
+
+            // 追加された物体と衝突し得る，待機している物体
+            for( l = n_objects; l < objects.size() && m_n_parked > 0; ++l )
+            {
+                if( objects[l]->get_bounding_box(box) ) wake_parked_objects(box.expand(m_broadphase_margin), true, false);
+                else                                    wake_all_parked(true);
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief 物体 @c index の矩形が @c old_box から変化していれば，空間ハッシュの情報が
+         *        古くなった物体として記録する
+         *
+         *  島ごとの衝突の計算中は，計算を行うワーカーの領域 @c buffer に並べる
+         * (m_collision_touched は計算の後でまとめて作る)．新しい矩形と衝突し得る待機している物体は，
+         * 時間発展を再開させる．
+         *
+         * @return 矩形が変化していれば true を返す．
+         */
+        bool
+        Manager::mark_moved_object (const std::size_t  index,
+                                    const BoundingBox& old_box,
+                                    DetectBuffer&      buffer)
+        {
+            BoundingBox box;
+
+            m_movable_objects[index]->get_bounding_box(box);
+            if( box == old_box ) return false;
+
+            // 待機している物体と衝突し得る位置へ動いた
+            if( m_n_parked > 0 ) wake_parked_objects(BoundingBox(box).expand(m_broadphase_margin), true, false);
+
+            if( ! m_collision_touched_flags[index] )
+            {
+                m_collision_touched_flags[index] = true;
+                if( m_resolving_islands ) buffer.moved.push_back(index);
+                else                      m_collision_touched.push_back(index);
+            }
+            if( m_touched_rehashed ) m_spatial_hash.insert(index, box);
+
             return true;
         }
 
+        /**
+         * @brief 位置・大きさが変化した movable 物体 @c index を，現在の矩形で空間ハッシュに登録し直す
+         *
+         *  古い矩形での登録も残るが，候補は現在の状態で絞り込む (filter_collision_candidates())
+         * ので，m_collision_touched の物体を全て候補に加える場合と結果は変わらない．
+         */
+        void
+        Manager::rehash_touched_object (const std::size_t index)
+        {
+            BoundingBox box;
+
+            if( index >= m_collision_touched_flags.size() || ! m_collision_touched_flags[index] ) return;
+            if( m_movable_objects[index]->get_bounding_box(box) ) m_spatial_hash.insert(index, box);
+        }
+
+        /**
+         * @brief 円同士の組のうち，確実に離れているものを候補 @c candidates から取り除く
+         *
+         *  @c slot は基準となる物体の，@c slots は候補の添字で引く各物体の CircleStore 上の
+         * スロットである．中心間の距離の 2 乗と半径の和の 2 乗を SIMD でまとめて比較するので，
+         * 衝突しない組に対して平方根の計算や衝突規則の呼び出しを行わずに済む．
+         * 円でない物体は常に候補に残す．
+         */
+        void
+        Manager::filter_overlapping_circles (const std::size_t               slot,
+                                             const std::vector<std::size_t>& slots,
+                                             std::vector<std::size_t>&       candidates,
+                                             DetectBuffer&                   buffer) const
+        {
+            std::size_t k, n, h;
+
+            if( slot == CircleStore::NO_SLOT ) return;
+
+            buffer.overlap_slots.clear();
+            for( k = 0; k < candidates.size(); ++k )
+            {
+                if( slots[candidates[k]] != CircleStore::NO_SLOT ) buffer.overlap_slots.push_back(slots[candidates[k]]);
+            }
+            if( buffer.overlap_slots.empty() ) return;
+
+            m_circle_store.test_overlap(slot, m_broadphase_margin, buffer.overlap_slots, buffer.gather, buffer.overlap_hits);
+
+            for( k = 0, n = 0, h = 0; k < candidates.size(); ++k )
+            {
+                if( slots[candidates[k]] != CircleStore::NO_SLOT && ! buffer.overlap_hits[h++] ) continue; // 確実に離れている
+
+                candidates[n++] = candidates[k];
+            }
+            candidates.resize(n);
+        }
+
+        /**
+         * @brief 物体 @c index と衝突し得る物体のうち，添字が @c first 以上のものを昇順に列挙する
+         *
+         *  添字が @c index より小さい物体は，衝突計算の開始時に休眠していたものだけを含める
+         * (@c substep が true なら全て含める)．島ごとの衝突の計算中は，@c index と同じ島に
+         * 属する物体だけを含める．@c buffer は作業領域である．
+         */
+        void
+        Manager::find_collision_candidates (const std::size_t         index,
+                                            const std::size_t         first,
+                                            const bool                substep,
+                                            std::vector<std::size_t>& result,
+                                            DetectBuffer&             buffer) const
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            BoundingBox box;
+            const bool bounded = objects[index]->get_bounding_box(box);
+            std::size_t i, n;
+
+            result.clear();
+
+            if( bounded )
+            {
+                m_spatial_hash.query(box.expand(m_broadphase_margin), result);
+            }
+            else
+            {
+                for( i = first; i < m_n_hashed; ++i )
+                {
+                    if( ! is_parked(i) ) result.push_back(i);
+                }
+            }
+
+            // 空間ハッシュの情報が古くなっている物体 (位置・大きさが変化したもの，追加されたもの)
+            if( m_resolving_islands )
+            {
+                // 島の外の物体は調べない (島の間で新たに生じた衝突は collide_island_boundaries() で扱う)
+                for( i = 0, n = 0; i < result.size(); ++i )
+                {
+                    if( in_island(index, result[i]) ) result[n++] = result[i];
+                }
+                result.resize(n);
+
+                result.insert(result.end(), buffer.moved.begin(), buffer.moved.end());
+            }
+            else if( ! m_touched_rehashed ) // 登録し直していれば，空間ハッシュへの問い合わせで見つかる
+            {
+                result.insert(result.end(), m_collision_touched.begin(), m_collision_touched.end());
+            }
+            for( i = m_n_hashed; i < objects.size(); ++i )
+            {
+                if( in_island(index, i) ) result.push_back(i);
+            }
+
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+
+            filter_collision_candidates(index, first, substep, result, buffer);
+        }
+
+        /**
+         * @brief 昇順に並べた候補 @c result から，物体 @c index と衝突し得ないものを取り除く
+         *
+         *  find_collision_candidates() と同じ条件で，現在の状態で判定する．
+         * 円同士の組は矩形の代わりに円そのものが重なっているかどうかを，まとめて判定する．
+         */
+        void
+        Manager::filter_collision_candidates (const std::size_t         index,
+                                              const std::size_t         first,
+                                              const bool                substep,
+                                              std::vector<std::size_t>& result,
+                                              DetectBuffer&             buffer) const
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            BoundingBox box, other_box;
+            const bool bounded = objects[index]->get_bounding_box(box);
+            const std::size_t slot = m_collision_slots[index];
+            std::size_t i, n;
+
+            if( bounded ) box.expand(m_broadphase_margin); // 空間ハッシュへの問い合わせと同じ矩形で判定する
+
+            // 現在の矩形が重なっているものだけを残す (円同士の組は後で判定する)
+            for( i = 0, n = 0; i < result.size(); ++i )
+            {
+                const std::size_t j = result[i];
+
+                if( j < first || j == index || ( j < index && ! substep && ! was_asleep(j) ) ) continue;
+                if( slot == CircleStore::NO_SLOT || m_collision_slots[j] == CircleStore::NO_SLOT )
+                {
+                    if( bounded && objects[j]->get_bounding_box(other_box) && ! box.intersects(other_box) ) continue;
+                }
+
+                result[n++] = j;
+            }
+            result.resize(n);
+
+            filter_overlapping_circles(slot, m_collision_slots, result, buffer);
+        }
+
+        /**
+         * @brief 全ての movable 物体について，衝突し得る組をワーカーで分担して検出する (detect)
+         *
+         *  @c fixed が false なら movable 物体との組を，true なら fixed 物体との組を検出する．
+         * 検出した組には，衝突規則の判定 (ObjectBase::detect()) も行って接触の情報を添える．
+         * いずれも物体の状態を変更しないので並列に行える．検出した組は物体ごとに m_detections に
+         * 記録するので，結果はワーカーの数や処理の割り当てによらない．
+         *
+         *  衝突の計算 (resolve) は，呼び出し側が物体の添字の順に行い，接触している組に応答
+         * (ObjectBase::respond()) だけを適用する．衝突によって状態が変化した物体は
+         * mark_changed_object() で記録し，検出した組と接触の情報を使う代わりに現在の状態で
+         * 調べ直すので，計算結果は逐次に検出する場合と変わらない．
+         */
+        void
+        Manager::detect_pairs (const bool fixed)
+        {
+            const std::size_t n = m_movable_objects.size();
+
+            for( std::size_t i = 0; i < m_detect_buffers.size(); ++i )
+            {
+                m_detect_buffers[i].pairs.clear();
+                m_detect_buffers[i].contacts.clear();
+                m_detect_buffers[i].manifolds.clear();
+                m_detect_buffers[i].changed.clear();
+            }
+
+            // ワーカーが 1 つで島に分けないなら，検出と衝突の計算を物体ごとに続けて行う (結果は同じ)
+            if( m_workers.size() == 1 && ! uses_islands() )
+            {
+                m_detections.clear();
+                m_detect_changed_flags.clear();
+                return;
+            }
+
+            m_detections.resize(n);
+            m_detect_changed_flags.assign(n, false);
+
+            MemberJob<Manager> job(*this, fixed ? &Manager::detect_fixed_object : &Manager::detect_movable_object);
+            m_workers.run(job, n);
+        }
+
+        /**
+         * @brief movable 物体 @c index と衝突し得る movable 物体を，ワーカー @c worker で検出する
+         *
+         *  衝突規則は collide_movable_object() と同じく，添字の小さい物体を基準に判定する．
+         */
+        void
+        Manager::detect_movable_object (const std::size_t  index,
+                                        const unsigned int worker)
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            DetectBuffer& buffer = m_detect_buffers[worker];
+            Detection& detection = m_detections[index];
+            std::size_t k;
+
+            detection.valid  = m_movable_objects[index]->get_alive() && ! was_asleep(index) && ! is_parked(index);
+            detection.worker = worker;
+            detection.first  = buffer.pairs.size();
+            detection.count  = 0;
+            if( ! detection.valid ) return;
+
+            save_detected_state(index);
+
+            find_collision_candidates(index, 0, false, buffer.candidates, buffer);
+            buffer.pairs.insert(buffer.pairs.end(), buffer.candidates.begin(), buffer.candidates.end());
+            detection.count = buffer.candidates.size();
+
+            buffer.contacts.resize(buffer.pairs.size());
+            buffer.manifolds.resize(buffer.pairs.size());
+            for( k = detection.first; k < buffer.pairs.size(); ++k )
+            {
+                const std::size_t j = buffer.pairs[k];
+
+                // 既に破棄された物体との組は計算しない
+                if( ! objects[j]->get_alive() ) buffer.contacts[k] = ObjectBase::DETECT_SEPARATED;
+                else buffer.contacts[k] = objects[std::min(index, j)]->detect(*objects[std::max(index, j)], buffer.manifolds[k]);
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c index と衝突し得る fixed 物体を，ワーカー @c worker で検出する
+         */
+        void
+        Manager::detect_fixed_object (const std::size_t  index,
+                                      const unsigned int worker)
+        {
+            const ObjectBase& object = *m_movable_objects[index];
+            const std::size_t slot = get_circle_slot(object);
+            DetectBuffer& buffer = m_detect_buffers[worker];
+            Detection& detection = m_detections[index];
+            std::size_t k;
+
+            detection.valid  = object.get_alive() && ! is_parked(index) &&
+                               ! ( slot != CircleStore::NO_SLOT && m_circle_store.is_sleeping(slot) );
+            detection.worker = worker;
+            detection.first  = buffer.pairs.size();
+            detection.count  = 0;
+            if( ! detection.valid ) return;
+
+            save_detected_state(index);
+
+            find_fixed_candidates(object, buffer.candidates, buffer);
+            buffer.pairs.insert(buffer.pairs.end(), buffer.candidates.begin(), buffer.candidates.end());
+            detection.count = buffer.candidates.size();
+
+            buffer.contacts.resize(buffer.pairs.size());
+            buffer.manifolds.resize(buffer.pairs.size());
+            for( k = detection.first; k < buffer.pairs.size(); ++k )
+            {
+                buffer.contacts[k] = object.detect(*m_fixed_objects[buffer.pairs[k]], buffer.manifolds[k]);
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c index の現在の矩形と，円であれば位置と半径を m_detections に記録する
+         */
+        void
+        Manager::save_detected_state (const std::size_t index)
+        {
+            const ObjectBase& object = *m_movable_objects[index];
+            Detection& detection = m_detections[index];
+
+            detection.bounded = object.get_bounding_box(detection.box);
+
+            if( get_circle_slot(object) != CircleStore::NO_SLOT )
+            {
+                const Circle& circle = static_cast<const Circle&>(object);
+                const Vector<double> position = circle.get_position();
+
+                detection.x      = position.get_x();
+                detection.y      = position.get_y();
+                detection.radius = circle.get_radius();
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c index の状態が，検出した時点から変化していないかどうか
+         *
+         *  矩形が同じでも円の位置や半径がわずかに変化していることがあるので，円は位置と
+         * 半径も比べる．
+         */
+        bool
+        Manager::is_detected_state (const std::size_t index) const
+        {
+            const ObjectBase& object = *m_movable_objects[index];
+            const Detection& detection = m_detections[index];
+            BoundingBox box;
+
+            if( object.get_bounding_box(box) != detection.bounded ) return false;
+            if( detection.bounded && box != detection.box ) return false;
+
+            if( get_circle_slot(object) != CircleStore::NO_SLOT )
+            {
+                const Circle& circle = static_cast<const Circle&>(object);
+                const Vector<double> position = circle.get_position();
+
+                if( position.get_x() != detection.x || position.get_y() != detection.y ) return false;
+                if( circle.get_radius() != detection.radius ) return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief 衝突した movable 物体 @c index の状態が検出した時点から変化していれば，
+         *        検出した組を使えない物体として記録する
+         *
+         *  検出を行わなかった物体 (休眠していたものなど) は状態を記録していないので，
+         * 変化したものとして扱う．記録した物体は，計算を行うワーカーの領域 @c buffer に並べる．
+         */
+        void
+        Manager::mark_changed_object (const std::size_t index,
+                                      DetectBuffer&     buffer)
+        {
+            if( index >= m_detect_changed_flags.size() || m_detect_changed_flags[index] ) return;
+            if( m_detections[index].valid && is_detected_state(index) ) return;
+
+            m_detect_changed_flags[index] = true;
+            buffer.changed.push_back(index);
+        }
+
+        /**
+         * @brief detect_pairs() で検出した，movable 物体 @c index と衝突し得る物体を @c result に
+         *        昇順に格納する
+         *
+         *  検出の後で状態が変化した物体と，追加された物体は現在の状態で調べ直す．状態が
+         * 変化しても矩形が変わっていない物体は，空間ハッシュに問い合わせ直して見つかるものだけを，
+         * 矩形が変わった物体は全てを調べ直すので，結果は find_collision_candidates() で求める
+         * 場合と一致する．問い合わせは状態が変化した物体があるときだけ行う．
+         * 状態が変化した物体は @c buffer に記録したものを使う．
+         *
+         *  各候補の検出した組の位置を @c buffer.target_pairs に格納する (調べ直したものは NO_PAIR)．
+         */
+        void
+        Manager::take_detected_candidates (const std::size_t         index,
+                                           std::vector<std::size_t>& result,
+                                           DetectBuffer&             buffer)
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            const Detection& detection = m_detections[index];
+            const std::vector<std::size_t>& pairs = m_detect_buffers[detection.worker].pairs;
+            const std::vector<std::size_t>& moved = m_resolving_islands ? buffer.moved : m_collision_touched;
+            std::vector<std::size_t>& changed = buffer.candidates;
+            std::vector<std::size_t>& positions = buffer.target_pairs;
+            BoundingBox box;
+            const bool bounded = objects[index]->get_bounding_box(box);
+            std::size_t k, n;
+
+            result.clear();
+            positions.clear();
+            for( k = detection.first; k < detection.first + detection.count; ++k )
+            {
+                if( m_detect_changed_flags[pairs[k]] ) continue;
+
+                result.push_back(pairs[k]);
+                positions.push_back(k);
+            }
+
+            changed.clear();
+            if( ! buffer.changed.empty() )
+            {
+                if( bounded )
+                {
+                    // 矩形が変わっていない物体は，空間ハッシュの登録と同じ位置にある
+                    m_spatial_hash.query(box.expand(m_broadphase_margin), changed);
+                    for( k = 0, n = 0; k < changed.size(); ++k )
+                    {
+                        const std::size_t j = changed[k];
+
+                        if( in_island(index, j) && m_detect_changed_flags[j] && ! m_collision_touched_flags[j] ) changed[n++] = j;
+                    }
+                    changed.resize(n);
+                    changed.insert(changed.end(), moved.begin(), moved.end());
+                }
+                else
+                {
+                    changed = buffer.changed;
+                }
+            }
+            for( k = m_n_hashed; k < objects.size(); ++k )
+            {
+                if( in_island(index, k) ) changed.push_back(k);
+            }
+            if( changed.empty() ) return;
+
+            std::sort(changed.begin(), changed.end());
+            changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+            filter_collision_candidates(index, 0, false, changed, buffer);
+
+            // 両者に共通の物体はないので，後ろから併合する
+            n = result.size();
+            k = changed.size();
+            result.resize(n + k);
+            positions.resize(n + k);
+            for( std::size_t l = result.size(); k > 0; )
+            {
+                --l;
+                if( n > 0 && result[n - 1] > changed[k - 1] )
+                {
+                    --n;
+                    result[l]    = result[n];
+                    positions[l] = positions[n];
+                }
+                else
+                {
+                    result[l]    = changed[--k];
+                    positions[l] = NO_PAIR;
+                }
+            }
+        }
+
+        /**
+         * @brief detect_pairs() で検出した movable 物体同士の組から，組でつながった物体の
+         *        集まり (島) を作る
+         *
+         *  fixed 物体は組に含まれないので，Field などを介して島がつながることはない．
+         * 休眠している物体は起きている物体との組を通じて島に含まれる．組を持たない物体は
+         * 島に属さない (NO_ISLAND)．島の物体は添字の昇順に並べる．
+         */
+        void
+        Manager::build_islands ()
+        {
+            const std::size_t n = m_detections.size();
+            std::vector<std::size_t>& ids   = m_island_ids;
+            std::vector<std::size_t>& sizes = m_island_members; // 島の物体を並べるまでは，根ごとの物体の数に使う
+            std::size_t i, k, total;
+
+            // 添字の最も小さい物体が根になるように，組でつながった物体を併合する
+            ids.resize(n);
+            for( i = 0; i < n; ++i ) ids[i] = i;
+            for( i = 0; i < n; ++i )
+            {
+                const Detection& detection = m_detections[i];
+                const std::vector<std::size_t>& pairs = m_detect_buffers[detection.worker].pairs;
+
+                if( ! detection.valid ) continue;
+
+                for( k = detection.first; k < detection.first + detection.count; ++k )
+                {
+                    const std::size_t a = find_root(ids, i);
+                    const std::size_t b = find_root(ids, pairs[k]);
+
+                    if( a < b ) ids[b] = a;
+                    else        ids[a] = b;
+                }
+            }
+
+            sizes.assign(n, 0);
+            for( i = 0; i < n; ++i )
+            {
+                ids[i] = find_root(ids, i);
+                ++sizes[ids[i]];
+            }
+
+            // 根の側から島の番号を付ける (根は島の中で最初に現れる)
+            m_islands.clear();
+            for( i = 0; i < n; ++i )
+            {
+                if( ids[i] != i )
+                {
+                    ids[i] = ids[ids[i]];
+                }
+                else if( sizes[i] < 2 )
+                {
+                    ids[i] = NO_ISLAND;
+                }
+                else
+                {
+                    const Island island = { 0, sizes[i], 0, false, 0, 0, 0 };
+
+                    ids[i] = m_islands.size();
+                    m_islands.push_back(island);
+                }
+            }
+
+            for( k = 0, total = 0; k < m_islands.size(); ++k )
+            {
+                m_islands[k].first = total;
+                total += m_islands[k].count;
+                m_islands[k].count = 0;
+            }
+
+            m_island_members.resize(total);
+            for( i = 0; i < n; ++i )
+            {
+                if( ids[i] == NO_ISLAND ) continue;
+
+                Island& island = m_islands[ids[i]];
+                m_island_members[island.first + island.count++] = i;
+                if( m_detections[i].valid ) island.cost += m_detections[i].count;
+                if( m_movable_objects[i]->get_alive() && m_movable_objects[i]->get_spawner() ) island.serial = true;
+            }
+        }
+
+        /**
+         * @brief movable 物体同士の衝突を，島ごとにワーカーで分担して計算する
+         *
+         *  異なる島の物体は衝突計算の開始時に衝突し得ないので，島の中の計算は他の島と
+         * 独立に行える．島の中では collide_movable_objects() と同じく添字の順に計算する．
+         * 島は重い順に並べて work stealing で分担するので，合成の続く Droplet の塊や
+         * Splitter の破片のような密な島があっても，ワーカーの負荷は偏らない．
+         * 物体を追加し得る島 (Splitter を含むもの) は，他の島の後で呼び出し元のスレッドで計算する．
+         *
+         *  接触の記録はワーカーごとの控え (DetectBuffer::journal) に溜め，全ての島を計算した
+         * 後で島の順に ContactSet へ反映する (異なる島の組が同じ記録を書き換えることはない)．
+         * 計算の途中で島の外の物体と新たに接触した組は collide_island_boundaries() で計算する．
+         * そのような組がなければ，結果は添字の順に全て逐次に計算する場合と一致する．
+         * いずれの場合も，結果はワーカーの数や島の割り当てによらない．
+         */
+        void
+        Manager::resolve_islands ()
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            std::size_t i, k, n_parallel;
+
+            build_islands();
+
+            m_island_order.clear();
+            for( k = 0; k < m_islands.size(); ++k )
+            {
+                if( ! m_islands[k].serial ) m_island_order.push_back(std::make_pair(m_islands[k].cost, k));
+            }
+            std::sort(m_island_order.begin(), m_island_order.end(), std::greater<std::pair<std::size_t, std::size_t> >());
+            n_parallel = m_island_order.size();
+
+            for( k = 0; k < m_islands.size(); ++k )
+            {
+                if( m_islands[k].serial ) m_island_order.push_back(std::make_pair(m_islands[k].cost, k));
+            }
+
+            m_resolving_islands = true;
+            for( k = 0; k < m_detect_buffers.size(); ++k ) m_detect_buffers[k].journal.clear();
+
+            MemberJob<Manager> job(*this, &Manager::resolve_island);
+            m_workers.run_stealing(job, n_parallel);
+
+            for( k = n_parallel; k < m_island_order.size(); ++k ) resolve_island(k, 0);
+
+            m_resolving_islands = false;
+
+            for( k = 0; k < m_islands.size(); ++k )
+            {
+                const Island& island = m_islands[k];
+                m_contacts.commit(m_detect_buffers[island.worker].journal, island.journal_first, island.journal_last);
+            }
+
+            // 島ごとの計算中に位置・大きさが変化した物体を，添字の順に並べ直す
+            m_collision_touched.clear();
+            for( i = 0; i < objects.size(); ++i )
+            {
+                if( m_collision_touched_flags[i] ) m_collision_touched.push_back(i);
+            }
+
+            collide_island_boundaries();
+            m_island_ids.clear();
+        }
+
+        /**
+         * @brief m_island_order の @c index 番目の島の衝突を，ワーカー @c worker で計算する
+         */
+        void
+        Manager::resolve_island (const std::size_t  index,
+                                 const unsigned int worker)
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            Island& island = m_islands[m_island_order[index].second];
+            const std::size_t n_objects = objects.size();
+            DetectBuffer& buffer = m_detect_buffers[worker];
+            std::size_t k, i;
+
+            buffer.changed.clear();
+            buffer.moved.clear();
+            island.worker        = worker;
+            island.journal_first = buffer.journal.size();
+            m_contacts.begin_journal(buffer.journal);
+
+            for( k = island.first; k < island.first + island.count; ++k )
+            {
+                i = m_island_members[k];
+                if( ! objects[i]->get_alive() || was_asleep(i) ) continue;
+
+                collide_movable_object(i, false, buffer);
+            }
+
+            // 島の中の衝突で追加された物体 (呼び出し元のスレッドで計算する島に限られる)
+            for( i = n_objects; i < objects.size(); ++i )
+            {
+                if( objects[i]->get_alive() ) collide_movable_object(i, false, buffer);
+            }
+
+            m_contacts.end_journal();
+            island.journal_last = buffer.journal.size();
+        }
+
+        /**
+         * @brief 島ごとの計算で状態が変化した物体と，他の島の物体との衝突を計算する
+         *
+         *  島ごとの計算では島の外の物体を調べないので，状態が変化した物体と追加された物体を
+         * 添字の順に，他の島 (または島に属さない) 物体と調べ直す．ここで状態が変化した物体も
+         * 続けて調べる．調べ終えた物体との組は調べない．
+         */
+        void
+        Manager::collide_island_boundaries ()
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            DetectBuffer& buffer = m_detect_buffers[0];
+            std::vector<std::size_t>& queue = buffer.changed; // mark_changed_object() で末尾に追加される
+            std::vector<std::size_t>& candidates = buffer.targets;
+            std::size_t i, k, l;
+
+            queue.clear();
+            for( i = 0; i < m_detect_changed_flags.size(); ++i )
+            {
+                if( m_detect_changed_flags[i] ) queue.push_back(i);
+            }
+            for( i = m_n_hashed; i < objects.size(); ++i ) queue.push_back(i);
+
+            m_island_done.assign(objects.size(), false);
+
+            for( l = 0; l < queue.size(); ++l )
+            {
+                const std::size_t index = queue[l];
+                const std::size_t island = m_island_ids[index];
+
+                m_island_done[index] = true;
+                if( ! objects[index]->get_alive() ) continue;
+
+                find_collision_candidates(index, 0, true, candidates, buffer);
+
+                for( k = 0; k < candidates.size() && objects[index]->get_alive(); ++k )
+                {
+                    const std::size_t j = candidates[k];
+                    BoundingBox box_i, box_j;
+                    bool moved = false, moved_j = false;
+
+                    if( ! objects[j]->get_alive() || m_island_done[j] ) continue;
+                    if( island != NO_ISLAND && m_island_ids[j] == island ) continue; // 島の中の組は計算済み
+                    if( was_asleep(index) && was_asleep(j) ) continue;
+
+                    const bool asleep_i = was_asleep(index);
+                    const bool asleep_j = was_asleep(j);
+
+                    objects[index]->get_bounding_box(box_i);
+                    objects[j]->get_bounding_box(box_j);
+                    if( ! objects[std::min(index, j)]->collide(*objects[std::max(index, j)]) ) continue;
+
+                    moved   = mark_moved_object(index, box_i, buffer);
+                    moved_j = mark_moved_object(j, box_j, buffer);
+                    mark_changed_object(j, buffer);
+
+                    if( asleep_i && objects[index]->get_alive() ) m_circle_store.disturb(m_collision_slots[index], moved);
+                    if( asleep_j && objects[j]->get_alive() ) m_circle_store.disturb(m_collision_slots[j], moved_j);
+
+                    const std::size_t n_objects = m_island_done.size();
+                    if( register_added_objects(index) )
+                    {
+                        for( i = n_objects; i < objects.size(); ++i ) queue.push_back(i);
+                        m_island_done.resize(objects.size(), false);
+                        moved = true;
+                    }
+
+                    if( moved ) // j より後ろの候補を探し直す
+                    {
+                        find_collision_candidates(index, j + 1, true, candidates, buffer);
+                        k = static_cast<std::size_t>(-1);
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief fixed 物体の AABB 木を構築する
+         *
+         *  矩形を持たない物体 (Field や Racket) は木に登録せず，常に衝突判定を行う．
+         * 格子にまとめた ForceField はどちらにも登録しない．
+         */
+        void
+        Manager::build_fixed_tree ()
+        {
+            BoundingBox box;
+
+            m_fixed_unbounded.clear();
+            m_fixed_tree.clear();
+
+            for( std::size_t i = 0; i < m_fixed_objects.size(); ++i )
+            {
+                // 格子にまとめた ForceField は衝突判定を行わない
+                if( std::find(m_force_fields.begin(), m_force_fields.end(), m_fixed_objects[i]) != m_force_fields.end() ) continue;
+
+                if( m_fixed_objects[i]->get_bounding_box(box) ) m_fixed_tree.insert(i, box);
+                else                                            m_fixed_unbounded.push_back(i);
+            }
+
+            m_fixed_tree.build();
+            m_fixed_tree_valid = true;
+        }
+
+        /**
+         * @brief movable 物体と fixed 物体の衝突を計算する
+         *
+         *  各 movable 物体について，AABB 木で近くにある fixed 物体だけを取り出し，
+         * m_fixed_objects の順に衝突を計算する (総当りの場合と同じ順序になる)．
+         * 衝突し得る組は detect_pairs() で検出しておき，検出の後で状態が変化した物体だけ
+         * 調べ直す．
+         */
+        void
+        Manager::collide_fixed_objects ()
+        {
+            std::size_t i;
+
+            if( ! m_fixed_tree_valid ) build_fixed_tree();
+
+            update_fixed_slots();
+            detect_pairs(true);
+
+            for( i = 0; i < m_movable_objects.size(); ++i )
+            {
+                ObjectBase& object = *m_movable_objects[i];
+                const std::size_t slot = get_circle_slot(object);
+
+                if( ! object.get_alive() || is_parked(i) ) continue;
+
+                // 休眠している物体は動かないので，fixed 物体 (これらも動かない) と新たに衝突することはない
+                if( slot != CircleStore::NO_SLOT && m_circle_store.is_sleeping(slot) ) continue;
+
+                if( i < m_detections.size() && m_detections[i].valid && is_detected_state(i) )
+                {
+                    collide_detected_fixed(i);
+                }
+                else
+                {
+                    collide_fixed_object(object, false);
+                }
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c object と，AABB 木で近くにある fixed 物体との衝突を計算する
+         */
+        void
+        Manager::collide_fixed_object (ObjectBase& object,
+                                       const bool  substep)
+        {
+            find_fixed_candidates(object, m_collision_candidates, m_detect_buffers[0]);
+            collide_fixed_candidates(object, substep, m_collision_candidates);
+        }
+
+        /**
+         * @brief movable 物体 @c object と，fixed 物体の添字の昇順に並べた候補 @c candidates との
+         *        衝突を計算する
+         *
+         *  ForceField の力は tick ごとに 1 回だけ加えるので，tick の分割した移動の後
+         * (@c substep が true) では ForceField を調べず，格子による力も加えない．
+         */
+        void
+        Manager::collide_fixed_candidates (ObjectBase&                     object,
+                                           const bool                      substep,
+                                           const std::vector<std::size_t>& candidates)
+        {
+            static const ObjectBase::ClassId globule_class    = ObjectBase::intern_class("Globule");
+            static const ObjectBase::ClassId forcefield_class = ObjectBase::intern_class("ForceField");
+
+            for( std::size_t k = 0; k < candidates.size() && object.get_alive(); ++k )
+            {
+                ObjectBase& other = *m_fixed_objects[candidates[k]];
+
+                if( substep && other.is(forcefield_class) ) continue;
+
+                object.collide(other);
+            }
+
+            if( ! substep && ! m_force_fields.empty() && object.get_alive() && object.is(globule_class) )
+            {
+                apply_force_fields(static_cast<Globule&>(object));
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c index と，detect_pairs() で検出した fixed 物体との衝突を計算する
+         *
+         *  collide_fixed_candidates() と同じ順に計算する．検出の際に求めた接触の情報は，
+         * 衝突によって物体の状態が変化するまで使う．
+         */
+        void
+        Manager::collide_detected_fixed (const std::size_t index)
+        {
+            static const ObjectBase::ClassId globule_class = ObjectBase::intern_class("Globule");
+
+            ObjectBase& object = *m_movable_objects[index];
+            const Detection& detection = m_detections[index];
+            const DetectBuffer& source = m_detect_buffers[detection.worker];
+            bool detected = true;
+
+            for( std::size_t k = detection.first; k < detection.first + detection.count && object.get_alive(); ++k )
+            {
+                ObjectBase& other = *m_fixed_objects[source.pairs[k]];
+                bool collided;
+
+                if( ! detected || source.contacts[k] == ObjectBase::DETECT_DEFERRED )
+                {
+                    collided = object.collide(other);
+                }
+                else if( source.contacts[k] == ObjectBase::DETECT_TOUCHING )
+                {
+                    collided = object.respond(other, source.manifolds[k]);
+                }
+                else
+                {
+                    continue;
+                }
+
+                if( collided && detected ) detected = is_detected_state(index);
+            }
+
+            if( ! m_force_fields.empty() && object.get_alive() && object.is(globule_class) )
+            {
+                apply_force_fields(static_cast<Globule&>(object));
+            }
+        }
+
+        /**
+         * @brief fixed 物体の CircleStore 上のスロットを m_fixed_slots に取得する
+         *
+         *  時間発展させない領域のスロットは，Globule が追加されるたびに動き得る
+         * (CircleStore::activate())．
+         */
+        void
+        Manager::update_fixed_slots ()
+        {
+            m_fixed_slots.resize(m_fixed_objects.size());
+            for( std::size_t i = 0; i < m_fixed_objects.size(); ++i ) m_fixed_slots[i] = get_circle_slot(*m_fixed_objects[i]);
+        }
+
+        /**
+         * @brief movable 物体 @c object と衝突し得る fixed 物体を，AABB 木で探して昇順に列挙する
+         *
+         *  円同士の組は円そのものが重なっているかどうかで絞り込む．@c buffer は作業領域である．
+         */
+        void
+        Manager::find_fixed_candidates (const ObjectBase&         object,
+                                        std::vector<std::size_t>& result,
+                                        DetectBuffer&             buffer) const
+        {
+            BoundingBox box;
+
+            result = m_fixed_unbounded;
+            if( object.get_bounding_box(box) )
+            {
+                m_fixed_tree.query(box.expand(m_broadphase_margin), result, buffer.stack);
+            }
+            else // 矩形を持たない movable 物体は全ての fixed 物体と衝突判定する
+            {
+                for( std::size_t k = 0; k < m_fixed_objects.size(); ++k ) result.push_back(k);
+            }
+
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+            filter_overlapping_circles(get_circle_slot(object), m_fixed_slots, result, buffer);
+        }
+
+        /**
+         * @brief Ball の @c step [s] の移動を調べ，途中で最初に衝突する物体があればその時刻の位置で止める
+         *
+         *  離散的な衝突判定では，1 tick の移動量が大きいと細い辺や小さな Droplet を
+         * すり抜けたり，Racket の判定が深く食い込んだ位置で行われたりする．ここでは
+         * tick の初めの位置 @c start から速度の方向へ掃いた円と各物体の接触時刻
+         * (ObjectBase::sweep()) を求め，最も早いものの位置へ Ball を戻す．衝突の応答は
+         * その位置で，続く衝突計算 (collide_movable_objects() など) の衝突規則が行う．
+         *
+         *  movable 物体との接触は，相手も同じ時間だけ等速で動くものとした相対運動で求める．
+         * Ball は相手の tick の終わりの位置に対して，接触した時刻と同じ向きで接する位置に置く
+         * (衝突の向きが正しくなる代わりに，Ball の位置は相手の移動量の分だけずれる)．
+         *
+         *  止めたために進めなかった時間は Ball に繰り越し，次の移動に加える
+         * (@c step を上限とする)．@c step は 1 tick，tick を分割して進める場合はその 1 回分である．
+         */
+        void
+        Manager::sweep_ball (const Vector<double>& start,
+                             const double          step)
+        {
+            static const ObjectBase::ClassId globule_class = ObjectBase::intern_class("Globule");
+            Ball& ball = *m_ball;
+            std::vector<std::size_t>& candidates = m_collision_candidates;
+            const double time = step + ball.get_carry_time();
+            const Vector<double> motion = ball.get_velocity() * time;
+            Vector<double> hit_start, hit_motion; // 接触した物体に対する相対運動
+            bool hit = false;
+            BoundingBox box(start, ball.get_radius()), other_box;
+            double toi = 1.0, t;
+            std::size_t i;
+
+            ball.set_carry_time(0.0);
+            if( ! ball.get_alive() || motion.is_zero() ) return;
+
+            box.merge(BoundingBox(start + motion, ball.get_radius()));
+            box.expand(m_broadphase_margin);
+
+            // fixed 物体 (Field や Racket のように矩形を持たないものは常に調べる)
+            if( ! m_fixed_tree_valid ) build_fixed_tree();
+            candidates = m_fixed_unbounded;
+            m_fixed_tree.query(box, candidates);
+            for( i = 0; i < candidates.size(); ++i )
+            {
+                const ObjectBase& object = *m_fixed_objects[candidates[i]];
+
+                if( ball.has_rule(object) && object.sweep(ball, start, motion, t) && t < toi )
+                {
+                    toi        = t;
+                    hit_start  = start;
+                    hit_motion = motion;
+                    hit        = true;
+                }
+            }
+
+            // 相手の移動の範囲も含めて重なり得る待機している物体は，時間発展を再開する
+            if( m_n_parked > 0 ) wake_parked_objects(BoundingBox(box).expand(m_parked_speed * time), true, false);
+
+            // movable 物体 (相手の移動を打ち消した相対運動で調べる)
+            for( i = 0; i < m_movable_objects.size(); ++i )
+            {
+                const ObjectBase& object = *m_movable_objects[i];
+
+                if( &object == m_ball || ! object.get_alive() || is_parked(i) || ! ball.has_rule(object) ) continue;
+
+                const Vector<double> shift = object.is(globule_class)
+                                           ? static_cast<const Globule&>(object).get_velocity() * time
+                                           : Vector<double>(0.0, 0.0);
+
+                if( object.get_bounding_box(other_box) ) // 相手の移動の範囲も含めて重なりを調べる
+                {
+                    other_box.merge(BoundingBox(other_box.left  - shift.get_x(), other_box.top    - shift.get_y(),
+                                                other_box.right - shift.get_x(), other_box.bottom - shift.get_y()));
+                    if( ! box.intersects(other_box) ) continue;
+                }
+
+                if( object.sweep(ball, start + shift, motion - shift, t) && t < toi )
+                {
+                    toi        = t;
+                    hit_start  = start + shift;
+                    hit_motion = motion - shift;
+                    hit        = true;
+                }
+            }
+
+            if( ! hit )
+            {
+                ball.set_position(start + motion);
+                return;
+            }
+
+            // 衝突した時刻の位置まで進め，わずかに食い込ませる
+            t = std::min(1.0, toi + m_sweep_slop / hit_motion.get_size());
+            ball.set_position(hit_start + hit_motion * t);
+            ball.set_carry_time(std::min((1.0 - t) * time, step));
+        }
+
+        /**
+         * @brief Ball の連続衝突判定を行うかどうかを設定する (検証用)
+         */
+        void
+        Manager::set_sweep_enabled (const bool enabled)
+        {
+            m_sweep_enabled = enabled;
+        }
+
+        bool
+        Manager::get_sweep_enabled ()
+        {
+            return m_sweep_enabled;
+        }
+
+        /**
+         * @brief Globule @c globule が時間 @c dt [s] の移動を何回に分けて進めるべきかを返す
+         *
+         *  1 回の移動量が半径の m_substep_length 倍を超えないように分け，m_max_substeps 回を
+         * 上限とする．
+         */
+        unsigned int
+        Manager::count_substeps (const Globule& globule,
+                                 const double   dt) const
+        {
+            if( ! m_substep_enabled || globule.get_radius() <= 0.0 ) return 1;
+
+            const double n = globule.get_velocity().get_size() * dt / (m_substep_length * globule.get_radius());
+
+            if( n <= 1.0 ) return 1;
+            if( n >= m_max_substeps ) return m_max_substeps;
+            return static_cast<unsigned int>(std::ceil(n));
+        }
+
+        /**
+         * @brief 半径に比べて速い movable 物体を選び，tick を分割した最初の 1 回分の位置まで戻す
+         *
+         *  integrate() の直後に呼び出す．選んだ物体は m_substeps に記録し，残りの移動は
+         * 衝突計算の後で run_substeps() が行う．遅い物体 (大半の Droplet) はこれまで通り
+         * 1 tick に 1 回だけ移動する．Ball の位置は連続衝突判定を行うなら sweep_ball() が決める．
+         */
+        void
+        Manager::plan_substeps (const double dt)
+        {
+            static const ObjectBase::ClassId globule_class = ObjectBase::intern_class("Globule");
+
+            m_substeps.clear();
+            if( ! m_substep_enabled ) return;
+
+            for( std::size_t i = 0; i < m_movable_objects.size(); ++i )
+            {
+                ObjectBase& object = *m_movable_objects[i];
+
+                if( ! object.get_alive() || ! object.is(globule_class) || is_parked(i) ) continue;
+
+                Globule& globule = static_cast<Globule&>(object);
+                const unsigned int count = count_substeps(globule, dt);
+
+                if( count <= 1 ) continue;
+
+                Substep substep;
+                substep.index = i;
+                substep.count = count;
+                m_substeps.push_back(substep);
+
+                if( &object == m_ball && m_sweep_enabled ) continue;
+
+                globule.set_position(globule.get_position() - globule.get_velocity() * (dt * (count - 1) / count));
+            }
+        }
+
+        /**
+         * @brief m_substeps に記録した高速な物体を，tick の残りの分だけ分割して進める
+         *
+         *  1 回進めるごとに，その物体と近くにある movable・fixed 物体との衝突を計算する
+         * (collide_movable_objects() の空間ハッシュを使い，ENGINE_EVENT では動いた物体を登録し直す)．
+         * 分割数の異なる物体は同じ回数目を 1 巡として順に進める．その間 get_time_step() は
+         * 分割した 1 回分の時間刻みを返すので，時間刻みに比例する衝突規則の補正が重複しない．
+         * 1 回進めるごとに ContactSet の段階を進めるので，この tick で既に衝突した組
+         * (collide_movable_objects() で計算したものを含む) は，衝突し続けている組として扱われる．
+         */
+        void
+        Manager::run_substeps (const double dt)
+        {
+            unsigned int round, max_count = 1;
+            std::size_t i;
+
+            for( i = 0; i < m_substeps.size(); ++i ) max_count = std::max(max_count, m_substeps[i].count);
+
+            // ENGINE_EVENT では，位置・大きさが変化した物体を毎回全て候補に加える代わりに，
+            // 現在の矩形で空間ハッシュに登録し直して問い合わせで見つける
+            if( m_engine == ENGINE_EVENT && max_count > 1 )
+            {
+                for( i = 0; i < m_collision_touched.size(); ++i ) rehash_touched_object(m_collision_touched[i]);
+                m_touched_rehashed = true;
+            }
+
+            for( round = 1; round < max_count; ++round )
+            {
+                for( i = 0; i < m_substeps.size(); ++i )
+                {
+                    const Substep& substep = m_substeps[i];
+                    ObjectBase& object = *m_movable_objects[substep.index];
+                    Globule& globule = static_cast<Globule&>(object);
+                    BoundingBox old_box;
+
+                    if( round >= substep.count || ! object.get_alive() ) continue;
+
+                    m_time_step = dt / substep.count;
+
+                    object.get_bounding_box(old_box);
+                    if( &object == m_ball && m_sweep_enabled ) sweep_ball(globule.get_position(), m_time_step);
+                    else globule.set_position(globule.get_position() + globule.get_velocity() * m_time_step);
+                    mark_moved_object(substep.index, old_box, m_detect_buffers[0]); // 空間ハッシュの情報は古くなる
+
+                    m_contacts.begin_pass(); // ここまでに衝突した組には，改めて衝突の応答をしない
+                    collide_movable_object(substep.index, true, m_detect_buffers[0]);
+                    if( object.get_alive() ) collide_fixed_object(object, true);
+                    if( m_touched_rehashed ) rehash_touched_object(substep.index); // 壁などに押し戻された
+                }
+            }
+
+            m_touched_rehashed = false;
+            m_time_step = dt;
+        }
+
+        /**
+         * @brief 高速な物体の移動を分割して衝突計算を行うかどうかを設定する (検証用)
+         */
+        void
+        Manager::set_substep_enabled (const bool enabled)
+        {
+            m_substep_enabled = enabled;
+        }
+
+        bool
+        Manager::get_substep_enabled ()
+        {
+            return m_substep_enabled;
+        }
+
+        /**
+         * @brief ENGINE_EVENT で，しばらく何とも衝突しない movable 物体を待機させる
+         *
+         *  simulate() の最後に呼び出す．各物体について，周りの物体 (fixed 物体，ForceField の力が
+         * 及び得る範囲，他の movable 物体) との隙間から，接触し得るまでに進む tick 数を予測する．
+         * 速度は粘性抵抗で減衰するだけなので，n tick の移動量は現在の速さの n tick 分を超えない．
+         * 予測した tick 数が m_min_park_ticks 以上の物体は，その間に動き得る範囲 (Parked::box) を
+         * m_parked_hash に登録し，CircleStore の時間発展させない領域へ移す．移動しない物体
+         * (休眠しているものなど) は予定を立てずに待機させる．
+         *
+         *  待機している物体の範囲は，他の待機している物体の範囲とも重ならない (休眠している物体
+         * 同士は衝突計算を行わないので，重なってよい)．起きている物体は待機させた後も動くので，
+         * 範囲に近づいた時点で時間発展を再開する (wake_parked_neighbours() など)．
+         * 予定の tick に達した物体は，その tick の初めに再開する (wake_due_objects())．
+         * 再開した物体は，それまでの tick を 1 つずつ進めた状態になる (CircleStore::replay()) ので，
+         * 結果は ENGINE_TICK と一致する．
+         *
+         *  Ball や advance() を呼び出す物体，Splitter，1 tick を分割して進める高速な物体は待機させない．
+         */
+        void
+        Manager::park_objects ()
+        {
+            static const ObjectBase::ClassId globule_class = ObjectBase::intern_class("Globule");
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            DetectBuffer& buffer = m_detect_buffers[0];
+            BoundingBox box;
+            double cell_size = 0.0;
+            std::size_t i;
+
+            // 起きている物体を現在の矩形で空間ハッシュに登録し直す (待機している物体は m_parked_hash で探す)
+            for( i = 0; i < objects.size(); ++i )
+            {
+                if( ! is_parked(i) && objects[i]->get_bounding_box(box) )
+                {
+                    cell_size = std::max(cell_size, box.get_width());
+                    cell_size = std::max(cell_size, box.get_height());
+                }
+            }
+            m_spatial_hash.reset(m_field ? m_field->get_region() : BoundingBox(), cell_size);
+            for( i = 0; i < objects.size(); ++i )
+            {
+                if( is_parked(i) ) continue;
+
+                if( objects[i]->get_bounding_box(box) ) m_spatial_hash.insert(i, box);
+                else                                    m_spatial_hash.insert(i);
+            }
+            m_collision_tick = 0; // 衝突計算の空間ハッシュではなくなった
+
+            for( i = 0; i < objects.size(); ++i )
+            {
+                ObjectBase& object = *objects[i];
+
+                if( is_parked(i) || &object == m_ball || ! object.is(globule_class) ) continue;
+                if( object.get_advanceable() || object.get_spawner() ) continue;
+
+                const Globule& globule = static_cast<const Globule&>(object);
+                const bool asleep = m_circle_store.is_sleeping(globule.get_slot());
+                const double speed = globule.get_velocity().get_size();
+                const unsigned int id = object.get_id();
+
+                if( id < m_parked.size() && m_tick < m_parked[id].retry ) continue; // 最近待機させられなかった
+                if( count_substeps(globule, m_park_dt) > 1 ) continue;
+
+                // 接触し得るまでの隙間 (待機させる最大の tick 数で進む距離と余裕より遠くは調べない．
+                // 静止している物体も，隙間が余裕を超えることは確かめる)
+                double gap = std::min(m_park_reach, 2.0 * m_park_slop + m_max_park_ticks * speed * m_park_dt);
+                gap = measure_fixed_gap(object, gap, buffer);
+                if( gap > m_park_slop ) gap = measure_movable_gap(i, asleep, gap, buffer);
+
+                const double ticks = speed > 0.0 ? (gap - m_park_slop) / (speed * m_park_dt) : 0.0;
+
+                if( gap <= m_park_slop || ( speed > 0.0 && ticks < m_min_park_ticks ) )
+                {
+                    defer_parking(id);
+                    continue;
+                }
+
+                if( speed == 0.0 ) // 動かないので，予定を立てずに待機させる
+                {
+                    park_object(i, 0.0, NO_WAKE, asleep);
+                    continue;
+                }
+
+                const unsigned long n_ticks = ticks < m_max_park_ticks ? static_cast<unsigned long>(ticks) : m_max_park_ticks;
+                park_object(i, n_ticks * speed * m_park_dt + m_park_slop, m_tick + n_ticks + 1, asleep);
+                m_parked_speed = std::max(m_parked_speed, speed);
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c index を，現在の矩形を @c reach だけ広げた範囲の中で待機させる
+         *
+         *  @c wake の tick の初めに時間発展を再開する (NO_WAKE なら予定を立てない)．@c asleep は
+         * 物体が休眠しているかどうかである．
+         */
+        void
+        Manager::park_object (const std::size_t   index,
+                              const double        reach,
+                              const unsigned long wake,
+                              const bool          asleep)
+        {
+            const ObjectBase& object = *m_movable_objects[index];
+            const unsigned int id = object.get_id();
+            BoundingBox box;
+
+            object.get_bounding_box(box);
+
+            Parked& parked = get_parked_record(id);
+            parked.parked  = true;
+            parked.index   = index;
+            parked.tick    = m_tick;
+            parked.wake    = wake;
+            parked.box     = box.expand(reach);
+            parked.asleep  = asleep;
+            parked.backoff = 0;
+            ++parked.stamp;
+
+            m_parked_hash.insert(id, parked.box);
+            m_circle_store.deactivate(get_circle_slot(object));
+            ++m_n_parked;
+
+            if( wake != NO_WAKE )
+            {
+                const WakeEvent event = { wake, id, parked.stamp };
+
+                m_wake_events.push_back(event);
+                std::push_heap(m_wake_events.begin(), m_wake_events.end(), is_later_wake);
+            }
+        }
+
+        /**
+         * @brief オブジェクト ID @c id の待機の記録を返す (なければ作る)
+         */
+        Manager::Parked&
+        Manager::get_parked_record (const unsigned int id)
+        {
+            if( id >= m_parked.size() )
+            {
+                const Parked empty = { false, 0, 0, NO_WAKE, BoundingBox(), false, 0, 0, 0 };
+                m_parked.resize(id + 1, empty);
+            }
+
+            return m_parked[id];
+        }
+
+        /**
+         * @brief 待機させられなかった物体 @c id を，しばらく park_objects() で調べ直さない
+         *
+         *  調べ直さない tick 数は，続けて待機させられなかった回数に応じて
+         * m_max_park_backoff まで倍に増やす (混み合った物体を毎 tick 調べる手間を省く)．
+         * 調べ直すまでは待機させないだけなので，結果は変わらない．
+         */
+        void
+        Manager::defer_parking (const unsigned int id)
+        {
+            Parked& parked = get_parked_record(id);
+
+            parked.backoff = parked.backoff > 0 ? std::min(2 * parked.backoff, m_max_park_backoff) : 1;
+            parked.retry   = m_tick + parked.backoff;
+        }
+
+        /**
+         * @brief 待機している movable 物体 @c index の時間発展を再開する
+         *
+         *  前の tick の終わりまで進めて，前の tick の状態として保存する．@c integrated が true なら
+         * 現在の tick の integrate() を行った後なので，現在の tick の分も進める．衝突計算の
+         * 空間ハッシュを構築した後であれば，物体を登録し，衝突計算の開始時から起きていたものと
+         * して扱う．
+         */
+        void
+        Manager::wake_parked_object (const std::size_t index,
+                                     const bool        integrated)
+        {
+            ObjectBase& object = *m_movable_objects[index];
+            Parked& parked = m_parked[object.get_id()];
+            std::size_t slot = get_circle_slot(object);
+            BoundingBox box;
+
+            m_parked_hash.remove(object.get_id(), parked.box);
+            parked.parked = false;
+            if( --m_n_parked == 0 ) m_parked_speed = 0.0;
+
+            m_circle_store.replay(slot, m_park_dt, m_tick - 1 - parked.tick);
+            m_circle_store.save_state(slot);
+            if( integrated ) m_circle_store.integrate(slot, m_park_dt);
+            m_circle_store.activate(slot);
+
+            if( m_collision_tick != m_tick ) return;
+
+            // 時間発展させない領域のスロットが入れ替わる
+            slot = get_circle_slot(object);
+            m_collision_slots[index]  = slot;
+            m_collision_asleep[index] = m_circle_store.is_sleeping(slot);
+            update_fixed_slots();
+
+            object.get_bounding_box(box);
+            m_spatial_hash.insert(index, box);
+        }
+
+        /**
+         * @brief 動き得る範囲が矩形 @c box と重なる，待機している物体の時間発展を全て再開する
+         *
+         *  @c asleep が true なら，休眠したまま待機している物体は再開しない (@c box が休眠している
+         * 物体のもので，休眠している物体同士は衝突計算を行わない場合)．@c integrated は
+         * wake_parked_object() に渡す．
+         */
+        void
+        Manager::wake_parked_objects (const BoundingBox& box,
+                                      const bool         integrated,
+                                      const bool         asleep)
+        {
+            std::vector<std::size_t>& candidates = m_parked_candidates;
+
+            candidates.clear();
+            m_parked_hash.query(box, candidates);
+            for( std::size_t k = 0; k < candidates.size(); ++k )
+            {
+                const Parked& parked = m_parked[candidates[k]];
+
+                if( ! parked.parked || ! parked.box.intersects(box) || ( asleep && parked.asleep ) ) continue;
+
+                wake_parked_object(parked.index, integrated);
+            }
+        }
+
+        /**
+         * @brief 待機している全ての物体の時間発展を再開する
+         */
+        void
+        Manager::wake_all_parked (const bool integrated)
+        {
+            for( std::size_t i = 0; i < m_movable_objects.size() && m_n_parked > 0; ++i )
+            {
+                if( is_parked(i) ) wake_parked_object(i, integrated);
+            }
+        }
+
+        /**
+         * @brief 待機を終える予定の tick に達した物体の時間発展を再開する
+         *
+         *  tick の初め (integrate() の前) に呼び出す．予定を立てた後で既に再開した物体の
+         * 予定は読み捨てる．
+         */
+        void
+        Manager::wake_due_objects ()
+        {
+            while( ! m_wake_events.empty() && m_wake_events.front().tick <= m_tick )
+            {
+                const WakeEvent event = m_wake_events.front();
+                const Parked& parked = m_parked[event.id];
+
+                std::pop_heap(m_wake_events.begin(), m_wake_events.end(), is_later_wake);
+                m_wake_events.pop_back();
+
+                if( parked.parked && parked.stamp == event.stamp ) wake_parked_object(parked.index, false);
+            }
+        }
+
+        /**
+         * @brief 起きている movable 物体と衝突し得る，待機している物体の時間発展を再開する
+         *
+         *  collide_movable_objects() で空間ハッシュを構築した直後に呼び出す．待機している物体が
+         * 起きている物体より少なければ，待機している物体の範囲ごとに空間ハッシュを調べ，
+         * そうでなければ起きている物体ごとに m_parked_hash を調べる．矩形を持たない物体があれば，
+         * 全ての物体を再開する．
+         */
+        void
+        Manager::wake_parked_neighbours ()
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            std::vector<std::size_t>& neighbours = m_detect_buffers[0].candidates;
+            BoundingBox box;
+            std::size_t i, k;
+
+            if( m_n_parked * 2 >= objects.size() )
+            {
+                for( i = 0; i < objects.size() && m_n_parked > 0; ++i )
+                {
+                    if( ! objects[i]->get_alive() || is_parked(i) ) continue;
+
+                    if( ! objects[i]->get_bounding_box(box) )
+                    {
+                        wake_all_parked(true);
+                        return;
+                    }
+
+                    wake_parked_objects(box.expand(m_broadphase_margin), true, m_collision_asleep[i]);
+                }
+                return;
+            }
+
+            for( i = 0; i < objects.size() && m_n_parked > 0; ++i )
+            {
+                if( ! is_parked(i) ) continue;
+
+                const Parked& parked = m_parked[objects[i]->get_id()];
+
+                neighbours.clear();
+                m_spatial_hash.query(BoundingBox(parked.box).expand(m_broadphase_margin), neighbours);
+                for( k = 0; k < neighbours.size(); ++k )
+                {
+                    const std::size_t j = neighbours[k]; // 空間ハッシュに待機している物体はない
+
+                    if( parked.asleep && m_collision_asleep[j] ) continue;
+
+                    if( ! objects[j]->get_bounding_box(box) )
+                    {
+                        wake_all_parked(true);
+                        return;
+                    }
+
+                    if( ! box.expand(m_broadphase_margin).intersects(parked.box) ) continue;
+
+                    wake_parked_object(i, true);
+                    break;
+                }
+            }
+        }
+
+        /**
+         * @brief m_wake_events を二分ヒープとして並べる比較関数 (@c a が @c b より後の予定か)
+         *
+         *  同じ tick の予定はオブジェクト ID の順に取り出す．
+         */
+        bool
+        Manager::is_later_wake (const WakeEvent& a,
+                                const WakeEvent& b)
+        {
+            return a.tick != b.tick ? a.tick > b.tick : a.id > b.id;
+        }
+
+        /**
+         * @brief 待機している物体を現在の tick の終わりまで進める (待機はさせたまま)
+         *
+         *  描画など，物体の位置を外から参照する前に呼び出す．前の tick の状態も保存するので，
+         * 描画時の補間も ENGINE_TICK と同じになる．
+         */
+        void
+        Manager::synchronize ()
+        {
+            for( std::size_t i = 0; i < m_movable_objects.size() && m_n_parked > 0; ++i )
+            {
+                if( ! is_parked(i) ) continue;
+
+                Parked& parked = m_parked[m_movable_objects[i]->get_id()];
+                const std::size_t slot = get_circle_slot(*m_movable_objects[i]);
+
+                if( parked.tick == m_tick ) continue;
+
+                m_circle_store.replay(slot, m_park_dt, m_tick - 1 - parked.tick);
+                m_circle_store.save_state(slot);
+                m_circle_store.replay(slot, m_park_dt, 1);
+                parked.tick = m_tick;
+            }
+        }
+
+        /**
+         * @brief movable 物体 @c index と，他の movable 物体 (待機している物体はその動き得る範囲) との
+         *        隙間を求める
+         *
+         *  隙間は矩形同士の距離から m_broadphase_margin を引いたものである．@c range より遠い物体は
+         * 調べないので，隙間は @c range を超えない．隙間が 0 以下になれば，そこで打ち切る．
+         * @c asleep が true なら休眠している物体は調べない
+         * (休眠している物体同士は衝突計算を行わない)．隙間を求められない (矩形を持たない物体が
+         * ある) 場合は負の値を返す．park_objects() で登録し直した空間ハッシュを使う．
+         * @c buffer は作業領域である．
+         */
+        double
+        Manager::measure_movable_gap (const std::size_t index,
+                                      const bool        asleep,
+                                      const double      range,
+                                      DetectBuffer&     buffer)
+        {
+            const std::vector<ObjectBase *>& objects = m_movable_objects;
+            std::vector<std::size_t>& neighbours = buffer.candidates;
+            BoundingBox box, other_box;
+            double gap = range;
+            std::size_t k;
+
+            if( ! objects[index]->get_bounding_box(box) ) return -1.0;
+
+            const BoundingBox area = BoundingBox(box).expand(m_broadphase_margin + range);
+
+            // 起きている物体 (この tick で待機させた物体は m_parked_hash で調べる)
+            neighbours.clear();
+            m_spatial_hash.query(area, neighbours);
+            for( k = 0; k < neighbours.size(); ++k )
+            {
+                const std::size_t j = neighbours[k];
+                const std::size_t slot = get_circle_slot(*objects[j]);
+
+                if( j == index || is_parked(j) ) continue;
+                if( asleep && slot != CircleStore::NO_SLOT && m_circle_store.is_sleeping(slot) ) continue;
+                if( ! objects[j]->get_bounding_box(other_box) ) return -1.0;
+
+                gap = std::min(gap, box.get_gap(other_box) - m_broadphase_margin);
+                if( gap <= 0.0 ) return gap;
+            }
+
+            // 待機している物体
+            m_parked_candidates.clear();
+            m_parked_hash.query(area, m_parked_candidates);
+            for( k = 0; k < m_parked_candidates.size(); ++k )
+            {
+                const Parked& parked = m_parked[m_parked_candidates[k]];
+
+                if( asleep && parked.asleep ) continue;
+
+                gap = std::min(gap, box.get_gap(parked.box) - m_broadphase_margin);
+            }
+
+            return gap;
+        }
+
+        /**
+         * @brief movable 物体 @c object と，衝突規則のある fixed 物体 (格子にまとめた ForceField は
+         *        力の及び得る範囲) との隙間を求める
+         *
+         *  隙間は ObjectBase::get_clearance() から m_broadphase_margin を引いたものである．
+         * @c range より遠い物体は調べないので，隙間は @c range を超えない．隙間が 0 以下になれば，
+         * そこで打ち切る．隙間を求められない場合は負の値を返す．@c buffer は作業領域である．
+         */
+        double
+        Manager::measure_fixed_gap (const ObjectBase& object,
+                                    const double      range,
+                                    DetectBuffer&     buffer) const
+        {
+            std::vector<std::size_t>& neighbours = buffer.candidates;
+            BoundingBox box;
+            double gap = range, clearance;
+            std::size_t k;
+
+            if( ! object.get_bounding_box(box) ) return -1.0;
+
+            neighbours = m_fixed_unbounded;
+            m_fixed_tree.query(BoundingBox(box).expand(m_broadphase_margin + range), neighbours, buffer.stack);
+            for( k = 0; k < neighbours.size(); ++k )
+            {
+                const ObjectBase& other = *m_fixed_objects[neighbours[k]];
+
+                if( ! object.has_rule(other) ) continue;
+                if( ! other.get_clearance(box, clearance) ) return -1.0;
+
+                gap = std::min(gap, clearance - m_broadphase_margin);
+                if( gap <= 0.0 ) return gap;
+            }
+
+            // 格子による力は，全ての Globule が受ける
+            for( k = 0; k < m_force_fields.size(); ++k )
+            {
+                const ForceField& field = *m_force_fields[k];
+                const BoundingBox reach(field.get_position(), field.get_radius() + m_force_reach);
+
+                gap = std::min(gap, box.get_gap(reach) - m_broadphase_margin);
+            }
+
+            return gap;
+        }
+
+        /**
+         * @brief 移動と衝突判定の方式を名前 ("tick", "event") で指定する
+         *
+         *  指定した方式は，以降に initialize() するステージ全てで，ステージ設定ファイルの
+         * [Field] の Engine より優先する．
+         */
+        bool
+        Manager::set_engine (const std::string& name)
+        {
+            if( ! parse_engine(name, m_forced_engine) )
+            {
+                dc_warning("'%s' という方式はありません", name.c_str());
+                return false;
+            }
+
+            m_engine_forced = true;
+            return true;
+        }
+
+        bool
+        Manager::parse_engine (const std::string& name,
+                               Engine&            engine)
+        {
+            if( name == get_engine_name(ENGINE_TICK) )  { engine = ENGINE_TICK;  return true; }
+            if( name == get_engine_name(ENGINE_EVENT) ) { engine = ENGINE_EVENT; return true; }
+
+            return false;
+        }
+
+        const char *
+        Manager::get_engine_name (const Engine engine)
+        {
+            switch( engine )
+            {
+                case ENGINE_TICK:  return "tick";
+                case ENGINE_EVENT: return "event";
+            }
+
+            return "unknown";
+        }
+
+        /**
+         * @brief 衝突し得る組の検出と衝突の計算に使うスレッド数 (呼び出し元のスレッドを含む) を指定する
+         *
+         *  以降に生成した Manager に適用する．衝突し得る組の検出を分担し，衝突は添字の順に
+         * 計算する (島ごとに分担するなら，島ごとの計算も分担する)．計算結果はスレッド数によらない．
+         */
+        void
+        Manager::set_n_threads (const unsigned int n_threads)
+        {
+            dc_return_if_fail(n_threads > 0);
+
+            m_n_threads = n_threads;
+        }
+
+        unsigned int
+        Manager::get_n_threads ()
+        {
+            return m_n_threads;
+        }
+
+        /**
+         * @brief movable 物体同士の衝突を島ごとに分担して計算するかどうかを設定する (既定は false)
+         *
+         *  false なら衝突し得る組の検出だけを分担し，衝突は添字の順に計算する．true なら
+         * 島ごとの計算も分担するが，島の間で新たに生じた接触は全ての島の後で計算するので，
+         * 結果は false の場合と異なり得る (いずれもスレッド数にはよらない)．
+         */
+        void
+        Manager::set_island_enabled (const bool enabled)
+        {
+            m_island_enabled = enabled;
+        }
+
+        bool
+        Manager::get_island_enabled ()
+        {
+            return m_island_enabled;
+        }
+
+        /**
+         * @brief 静的な ForceField をまとめた格子を構築する
+         *
+         *  ステージ設定ファイルの [Field] に ForceGridCellSize がある場合にだけ構築する．
+         * ForceField の力は受ける側の半径にも依存するので，ForceGridRadiusStep 刻みで
+         * ForceGridMaxRadius までの半径について格子を作る．
+         */
+        void
+        Manager::build_force_grid ()
+        {
+            static const ObjectBase::ClassId forcefield_class = ObjectBase::intern_class("ForceField");
+            std::size_t i;
+
+            m_force_grid.clear();
+            m_force_fields.clear();
+            m_force_reach = 0.0;
+
+            if( ForceGrid::get_exact() ) return;
+            if( m_field == 0 || ! m_file.has_key("Field", "ForceGridCellSize") ) return;
+
+            for( i = 0; i < m_fixed_objects.size(); ++i )
+            {
+                if( m_fixed_objects[i]->is(forcefield_class) )
+                {
+                    m_force_fields.push_back(static_cast<const ForceField *>(m_fixed_objects[i]));
+                }
+            }
+            if( m_force_fields.empty() ) return;
+
+            const double cell_size   = m_file.get_double("Field", "ForceGridCellSize", 0.5, 65535);
+            const double radius_step = m_file.has_key("Field", "ForceGridRadiusStep")
+                                     ? m_file.get_double("Field", "ForceGridRadiusStep", 0.5, 65535)
+                                     : 4.0;
+            const double max_radius  = m_file.has_key("Field", "ForceGridMaxRadius")
+                                     ? m_file.get_double("Field", "ForceGridMaxRadius", 0, 65535)
+                                     : 64.0;
+
+            m_force_grid.build(m_field->get_region(), cell_size, radius_step, max_radius, m_force_fields);
+            // 補間により，格子点 (対角に 2 セル以内) と半径の刻み 1 つ分だけ遠くまで力が及び得る
+            m_force_reach = radius_step + 2.0 * cell_size + 1.0;
+            m_fixed_tree_valid = false; // ForceField を AABB 木から除く
+        }
+
+        /**
+         * @brief 格子にまとめた ForceField による加速度で，Globule の速度を現在の時間刻みの分だけ変える
+         *
+         *  格子で扱えない Globule (格子の外にあるもの，半径が大きすぎるもの) は，
+         * ForceField ごとに厳密に計算する．
+         */
+        void
+        Manager::apply_force_fields (Globule& globule)
+        {
+            Vector<double> force;
+
+            if( m_force_grid.sample(globule.get_position(), globule.get_radius(), force) )
+            {
+                globule.set_velocity(globule.get_velocity() + force * m_time_step);
+                if( force.get_x() != 0.0 || force.get_y() != 0.0 ) globule.wake(); // 力を受けている間は休眠させない
+                return;
+            }
+
+            for( std::size_t i = 0; i < m_force_fields.size(); ++i )
+            {
+                ForceField::collide_with_globule(*m_force_fields[i], globule);
+            }
+        }
+
+        /**
+         * @brief 各グループの Droplet が全て 1 つに合成されたかどうか
+         *
+         *  グループごとの Droplet の数は登録・合成 (死亡)・グループ ID の変更のたびに
+         * 更新しているので，ここでは数え直さない．
+         */
+        bool
+        Manager::check_gameclear () const
+        {
+            return m_n_unmerged_groups == 0;
+        }
+
+        void
+        Manager::add_to_group (const int group_id)
+        {
+            if( ++m_group_sizes[group_id] == 2 ) ++m_n_unmerged_groups;
+        }
+
+        void
+        Manager::remove_from_group (const int group_id)
+        {
+            std::map<int, std::size_t>::iterator it = m_group_sizes.find(group_id);
+
+            dc_return_if_fail(it != m_group_sizes.end());
+
+            if( it->second-- == 2 ) --m_n_unmerged_groups;
+            if( it->second == 0 ) m_group_sizes.erase(it);
+        }
+
+        /**
+         * @brief 登録済みの Droplet のグループ ID が変更されたことを通知する
+         */
+        void
+        Manager::change_group (const int old_group_id,
+                               const int new_group_id)
+        {
+            if( old_group_id == new_group_id ) return;
+
+            remove_from_group(old_group_id);
+            add_to_group(new_group_id);
+        }
+
+        /**
+         * @brief 全ての物体を描画する
+         *
+         *  @c alpha は最後の tick から経過した実時間の，1 tick に対する割合 (0 以上 1 以下) で，
+         * movable 物体は 1 つ前の tick の状態から現在の状態までを @c alpha で補間した位置に描く
+         * (表示は最大で 1 tick 遅れる)．
+         */
         void
-        Manager::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        Manager::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                       const double                         alpha) const
         {
-            std::list<ObjectBase *>::const_iterator it;
+            const double t = std::min(std::max(alpha, 0.0), 1.0);
+            std::size_t i;
 
             // fixed 物体を描画する
-            for( it = m_fixed_list.begin(); it != m_fixed_list.end(); ++it ) (*it)->draw(cr);
+            for( i = 0; i < m_fixed_objects.size(); ++i ) m_fixed_objects[i]->draw(cr, t);
 
-            // movable 物体を描画する
-            for( it = m_movable_list.begin(); it != m_movable_list.end(); ++it ) (*it)->draw(cr);
+            // movable 物体を描画する (前の tick から現在までを t で補間した位置に描く)
+            for( i = 0; i < m_movable_objects.size(); ++i ) m_movable_objects[i]->draw(cr, t);
 
             // ゲームオーバーの表示
             if( m_state == STATE_GAMEOVER )
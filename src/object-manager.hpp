@@ -22,20 +22,31 @@
 #  include "config.h"
 #endif
 
+#include <map>
 #include <string>
-#include <list>
+#include <utility>
+#include <vector>
 #include <gdkmm/pixbuf.h>
 #include <cairomm/cairomm.h>
 #include "settingfile.hpp"
+#include "workerpool.hpp"
+#include "object-spatialhash.hpp"
+#include "object-aabbtree.hpp"
+#include "object-contactset.hpp"
+#include "object-objectbase.hpp"
+#include "object-objectpool.hpp"
+#include "object-circlestore.hpp"
+#include "object-forcegrid.hpp"
 
 namespace DropletCollection
 {
     namespace Object
     {
-        class ObjectBase;
         class Field;
         class Racket;
         class Ball;
+        class Globule;
+        class ForceField;
 
         class Manager
         {
@@ -48,27 +59,181 @@ namespace DropletCollection
                     STATE_GAMECLEAR
                 };
 
+                // 物体の移動と衝突判定の方式
+                enum Engine
+                {
+                    ENGINE_TICK,  //< tick の終わりの位置で衝突を判定する (高速な物体は分割して進める)
+                    ENGINE_EVENT  //< 物体ごとに次に衝突し得る tick を予測し，それまでの計算を省く (結果は ENGINE_TICK と同じ)
+                };
+
+                /**
+                 * @brief 物体を参照するためのハンドル
+                 *
+                 *  物体が破棄されると世代が進むので，オブジェクト ID が再利用されても古いハンドル
+                 * が別の物体を指すことはない．
+                 */
+                struct Handle
+                {
+                    unsigned int id;
+                    unsigned int generation;
+                };
+
+                // 物体とオブジェクト ID の使用状況
+                struct Statistics
+                {
+                    std::size_t n_fixed;      //< 生存している fixed 物体の数
+                    std::size_t n_movable;    //< 生存している movable 物体の数
+                    std::size_t n_ids;        //< 割り当て中のオブジェクト ID の数 (Splitter の部品を含む)
+                    std::size_t n_pooled_ids; //< 解放され，再利用を待っているオブジェクト ID の数
+                    std::size_t n_reclaimed;  //< これまでに回収した movable 物体の数
+                    std::size_t n_chunks;     //< 物体のメモリプールが確保したチャンクの数
+                    std::size_t n_sleeping;   //< 休眠している movable 物体の数
+                };
+
                  Manager (const std::string& filename);
                 ~Manager ();
 
                 inline State  get_state   () const;
                 inline void   set_state   (State state);
+                inline unsigned long get_tick () const;
+                inline double get_time_step () const;
+                inline Engine get_engine  () const;
                 double        get_width   () const;
                 double        get_height  () const;
                 void          move_racket (double x);
                 void          launch      ();
+                Statistics    get_statistics () const;
 
                 template <class ChildT>
-                inline ChildT * attach     ();
+                inline ChildT * attach       ();
                 template <class ChildT>
-                inline ChildT * attach     (const ChildT& other);
-                bool            exists     (const ObjectBase& object) const;
-                void            clear      ();
-                void            initialize ();
-                void            simulate   ();
-                void            draw       (const Cairo::RefPtr<Cairo::Context>& cr) const;
+                inline ChildT * attach       (const ChildT& other);
+                Handle          get_handle   (const ObjectBase& object) const;
+                ObjectBase *    lookup       (const Handle& handle) const;
+                bool            exists       (const Handle& handle) const;
+                bool            exists       (const ObjectBase& object) const;
+                void            clear        ();
+                void            initialize   ();
+                void            simulate     (double dt);
+                void            fast_forward (double        dt,
+                                              unsigned long n_ticks);
+                void            synchronize  ();
+                void            draw         (const Cairo::RefPtr<Cairo::Context>& cr,
+                                              double                               alpha) const;
+
+                static void         set_sweep_enabled   (bool enabled);
+                static bool         get_sweep_enabled   ();
+                static void         set_substep_enabled (bool enabled);
+                static bool         get_substep_enabled ();
+                static bool         set_engine          (const std::string& name);
+                static const char * get_engine_name     (Engine engine);
+                static void         set_n_threads       (unsigned int n_threads);
+                static unsigned int get_n_threads       ();
+                static void         set_island_enabled  (bool enabled);
+                static bool         get_island_enabled  ();
+
+                // For DropletCollection::Object::ObjectBase
+                unsigned int              allocate_object_id ();
+                void                      release_object_id  (unsigned int id);
+                inline ContactSet&        get_contacts       ();
+                inline const ContactSet&  get_contacts       () const;
+                inline ObjectPool&        get_object_pool    ();
+                inline CircleStore&       get_circle_store   ();
+
+                // For DropletCollection::Object::Droplet
+                void                      change_group       (int old_group_id,
+                                                              int new_group_id);
 
             private:
+                // オブジェクト ID ごとの登録状況
+                struct Slot
+                {
+                    ObjectBase * object;     //< 登録されている物体 (未登録なら 0)
+                    unsigned int generation; //< 物体が破棄されるたびに進む
+                };
+
+                // 1 tick を分割して進める高速な movable 物体
+                struct Substep
+                {
+                    std::size_t  index; //< m_movable_objects 上の添字
+                    unsigned int count; //< 1 tick の分割数 (2 以上)
+                };
+
+                // 衝突し得る組の検出 (detect) に使う領域．ワーカーごとに持つ
+                struct DetectBuffer
+                {
+                    std::vector<std::size_t>   pairs;         //< 検出した組の相手の添字 (物体ごとに連続して並べる)
+                    std::vector<unsigned char> contacts;      //< 組ごとの ObjectBase::detect() の結果 (pairs と同じ位置)
+                    std::vector<ObjectBase::Manifold> manifolds; //< 組ごとの接触の情報 (接触している組だけ意味を持つ)
+                    std::vector<std::size_t>   changed;       //< 検出の後で状態が変化した物体の添字 (島ごと)
+                    std::vector<std::size_t>   moved;         //< 島の中で位置・大きさが変化した物体の添字
+                    std::vector<std::size_t>   targets;       //< 衝突を計算する候補
+                    std::vector<std::size_t>   target_pairs;  //< 候補ごとの pairs 上の位置 (NO_PAIR なら現在の状態で調べ直したもの)
+                    std::vector<std::size_t>   candidates;    //< 以下は作業領域
+                    std::vector<std::size_t>   overlap_slots;
+                    std::vector<unsigned char> overlap_hits;
+                    CircleStore::Gather        gather;
+                    std::vector<std::size_t>   stack;         //< AABBTree::query() の作業領域
+                    ContactSet::Journal        journal;       //< 島ごとの計算で記録した接触の控え
+                };
+
+                // movable 物体ごとの検出結果と，検出した時点の状態
+                struct Detection
+                {
+                    bool         valid;   //< 衝突計算を行う物体として組を検出したかどうか
+                    unsigned int worker;  //< 組を格納した DetectBuffer
+                    std::size_t  first;   //< DetectBuffer::pairs 上の先頭位置
+                    std::size_t  count;   //< 組の数
+                    bool         bounded; //< 以下は検出した時点の矩形と，円であれば位置と半径
+                    BoundingBox  box;
+                    double       x;
+                    double       y;
+                    double       radius;
+                };
+
+                // 衝突し得る組でつながった movable 物体の集まり (島)
+                struct Island
+                {
+                    std::size_t  first;  //< m_island_members 上の先頭位置
+                    std::size_t  count;  //< 物体の数
+                    std::size_t  cost;   //< 検出した組の数 (計算量の見積もり)
+                    bool         serial; //< 物体を追加し得るので，呼び出し元のスレッドで計算する
+                    unsigned int worker; //< 以下は計算したワーカーと，その DetectBuffer::journal 上の記録の範囲
+                    std::size_t  journal_first;
+                    std::size_t  journal_last;
+                };
+
+                /**
+                 * @brief ENGINE_EVENT で時間発展を止めている (待機させている) movable 物体の状態
+                 *
+                 *  オブジェクト ID で引く．待機している物体の CircleStore 上の状態は @c tick の
+                 * 終わりのまま止まっており，必要になった時点で現在の tick まで進める．
+                 */
+                struct Parked
+                {
+                    bool          parked;  //< 待機しているかどうか
+                    std::size_t   index;   //< m_movable_objects 上の添字
+                    unsigned long tick;    //< CircleStore 上の状態がどの tick の終わりのものか
+                    unsigned long wake;    //< この tick の初めまでに時間発展を再開する (NO_WAKE なら予定はない)
+                    BoundingBox   box;     //< 待機している間に物体が動き得る範囲
+                    bool          asleep;  //< 待機させた時点で休眠していたかどうか
+                    unsigned int  stamp;   //< 待機させるたびに進む (古い WakeEvent を見分ける)
+                    unsigned long retry;   //< 待機させられなかった物体を，この tick まで調べ直さない
+                    unsigned long backoff; //< 調べ直さない tick 数 (待機させると 0 に戻す)
+                };
+
+                // 待機している物体の時間発展を再開する予定 (m_wake_events に tick の早い順に並べる)
+                struct WakeEvent
+                {
+                    unsigned long tick;
+                    unsigned int  id;    //< 物体のオブジェクト ID
+                    unsigned int  stamp; //< 予定を立てた時点の Parked::stamp
+                };
+
+                static const std::size_t   NO_ISLAND = static_cast<std::size_t>(-1);
+                static const std::size_t   NO_PAIR   = static_cast<std::size_t>(-1);
+                static const unsigned long NO_WAKE   = static_cast<unsigned long>(-1);
+
                 Manager (); // Do not call!
                 Manager (const Manager& other); // Do not call!
                 Manager& operator = (const Manager& other); // Do not call!
@@ -77,16 +242,196 @@ namespace DropletCollection
                 void initialize_optional_object (const std::string& class_name,
                                                  const std::string& object_name);
                 bool check_gameclear            () const;
+                void add_to_group               (int                       group_id);
+                void remove_from_group          (int                       group_id);
+                void begin_tick                 (double                    dt);
+                void collide_movable_objects    ();
+                void collide_movable_object     (std::size_t               index,
+                                                 bool                      substep,
+                                                 DetectBuffer&             buffer);
+                bool collide_movable_pair       (std::size_t               index,
+                                                 std::size_t               other,
+                                                 std::size_t               pair);
+                bool register_added_objects     (std::size_t               index);
+                void build_islands              ();
+                void resolve_islands            ();
+                void resolve_island             (std::size_t               index,
+                                                 unsigned int              worker);
+                void collide_island_boundaries  ();
+                inline bool in_island           (std::size_t               index,
+                                                 std::size_t               other) const;
+                void collide_fixed_objects      ();
+                void collide_fixed_object       (ObjectBase&               object,
+                                                 bool                      substep);
+                void collide_fixed_candidates   (ObjectBase&                     object,
+                                                 bool                            substep,
+                                                 const std::vector<std::size_t>& candidates);
+                void collide_detected_fixed     (std::size_t               index);
+                void update_fixed_slots         ();
+                void find_fixed_candidates      (const ObjectBase&         object,
+                                                 std::vector<std::size_t>& result,
+                                                 DetectBuffer&             buffer) const;
+                void detect_pairs               (bool                      fixed);
+                void detect_movable_object      (std::size_t               index,
+                                                 unsigned int              worker);
+                void detect_fixed_object        (std::size_t               index,
+                                                 unsigned int              worker);
+                void save_detected_state        (std::size_t               index);
+                bool is_detected_state          (std::size_t               index) const;
+                void mark_changed_object        (std::size_t               index,
+                                                 DetectBuffer&             buffer);
+                void take_detected_candidates   (std::size_t               index,
+                                                 std::vector<std::size_t>& result,
+                                                 DetectBuffer&             buffer);
+                unsigned int count_substeps     (const Globule&            globule,
+                                                 double                    dt) const;
+                void plan_substeps              (double                    dt);
+                void run_substeps               (double                    dt);
+                void rehash_touched_object      (std::size_t               index);
+                inline bool uses_islands        () const;
+                inline bool is_parked           (std::size_t               index) const;
+                void park_objects               ();
+                void park_object                (std::size_t               index,
+                                                 double                    reach,
+                                                 unsigned long             wake,
+                                                 bool                      asleep);
+                Parked& get_parked_record       (unsigned int              id);
+                void defer_parking              (unsigned int              id);
+                void wake_parked_object         (std::size_t               index,
+                                                 bool                      integrated);
+                void wake_parked_objects        (const BoundingBox&        box,
+                                                 bool                      integrated,
+                                                 bool                      asleep);
+                void wake_all_parked            (bool                      integrated);
+                static bool is_later_wake       (const WakeEvent&          a,
+                                                 const WakeEvent&          b);
+                void wake_due_objects           ();
+                void wake_parked_neighbours     ();
+                double measure_movable_gap      (std::size_t               index,
+                                                 bool                      asleep,
+                                                 double                    range,
+                                                 DetectBuffer&             buffer);
+                double measure_fixed_gap        (const ObjectBase&         object,
+                                                 double                    range,
+                                                 DetectBuffer&             buffer) const;
+                static bool parse_engine        (const std::string&        name,
+                                                 Engine&                   engine);
+                void build_fixed_tree           ();
+                void build_force_grid           ();
+                void apply_force_fields         (Globule&                  globule);
+                void sweep_ball                 (const Vector<double>&     start,
+                                                 double                    step);
+                void find_collision_candidates  (std::size_t               index,
+                                                 std::size_t               first,
+                                                 bool                      substep,
+                                                 std::vector<std::size_t>& result,
+                                                 DetectBuffer&             buffer) const;
+                void filter_collision_candidates (std::size_t               index,
+                                                  std::size_t               first,
+                                                  bool                      substep,
+                                                  std::vector<std::size_t>& result,
+                                                  DetectBuffer&             buffer) const;
+                inline bool was_asleep          (std::size_t               index) const;
+                bool mark_moved_object          (std::size_t               index,
+                                                 const BoundingBox&        old_box,
+                                                 DetectBuffer&             buffer);
+                void filter_overlapping_circles (std::size_t                     slot,
+                                                 const std::vector<std::size_t>& slots,
+                                                 std::vector<std::size_t>&       candidates,
+                                                 DetectBuffer&                   buffer) const;
+
+                static const double        m_broadphase_margin;
+                static const double        m_sweep_slop;
+                static bool                m_sweep_enabled;
+                static const double        m_substep_length;
+                static const unsigned int  m_max_substeps;
+                static bool                m_substep_enabled;
+                static const double        m_park_reach;
+                static const unsigned long m_max_park_ticks;
+                static const unsigned long m_min_park_ticks;
+                static const unsigned long m_max_park_backoff;
+                static const double        m_park_slop;
+                static bool                m_engine_forced; //< コマンドラインで方式が指定されたかどうか
+                static Engine              m_forced_engine;
+                static unsigned int        m_n_threads; //< 衝突の検出と計算に使うスレッド数
+                static bool                m_island_enabled;
 
                 SettingFile               m_file;
                 State                     m_state;
-                std::list<ObjectBase *>   m_fixed_list;
-                std::list<ObjectBase *>   m_movable_list;
+                Engine                    m_engine;
+                unsigned long             m_tick; //< これまでに進めた tick 数
+                double                    m_time_step; //< 現在の tick の時間刻み [s]
+                std::vector<ObjectBase *> m_fixed_objects;   //< 登録順に並べた fixed 物体
+                std::vector<ObjectBase *> m_movable_objects; //< 登録順に並べた movable 物体
+                std::vector<ObjectBase *> m_advanceable_objects; //< advance() を呼び出す movable 物体
+                std::vector<Slot>         m_slots;           //< オブジェクト ID を添字とする
                 Field                   * m_field;
                 Racket                  * m_racket;
                 Ball                    * m_ball;
                 Glib::RefPtr<Gdk::Pixbuf> m_image_gameover;
                 Glib::RefPtr<Gdk::Pixbuf> m_image_gameclear;
+
+                ObjectPool                m_object_pool; //< 全ての物体はここから確保する
+                CircleStore               m_circle_store; //< 全ての Circle の位置・速度など
+
+                // オブジェクト ID の管理と衝突の記録
+                ContactSet                m_contacts;
+                unsigned int              m_next_id; //< まだ一度も割り当てていない最小の ID
+                std::vector<unsigned int> m_free_ids; //< 再利用できる ID
+                std::vector<unsigned int> m_released_ids[2]; //< 解放後，衝突の記録から消えるのを待っている ID
+                std::size_t               m_n_reclaimed; //< これまでに回収した movable 物体の数
+
+                // ゲームクリアの判定に利用する
+                std::map<int, std::size_t> m_group_sizes; //< グループ ID ごとの生存している Droplet の数
+                std::size_t               m_n_unmerged_groups; //< Droplet が 2 つ以上残っているグループの数
+
+                // movable-movable 間の衝突計算 (broad phase) に利用する
+                SpatialHash               m_spatial_hash;
+                std::vector<std::size_t>  m_collision_candidates;
+                std::vector<std::size_t>  m_collision_touched; //< 衝突計算中に位置・大きさが変化した物体の添字
+                std::vector<unsigned char> m_collision_touched_flags;
+                std::size_t               m_n_hashed; //< 空間ハッシュに登録した物体の数
+                bool                      m_touched_rehashed; //< m_collision_touched の物体を現在の矩形で空間ハッシュに登録し直している
+                std::vector<std::size_t>  m_collision_slots; //< movable 物体の CircleStore 上のスロット
+                std::vector<unsigned char> m_collision_asleep; //< 衝突計算の開始時に休眠していた物体
+
+                // 高速な movable 物体の分割した移動と衝突計算に利用する
+                std::vector<Substep>      m_substeps;
+
+                // ENGINE_EVENT で，しばらく何とも衝突しない物体の時間発展を止めておく (park_objects())
+                std::vector<Parked>       m_parked;            //< オブジェクト ID で引く
+                std::vector<WakeEvent>    m_wake_events;       //< 二分ヒープ (先頭が最も早い予定)
+                SpatialHash               m_parked_hash;       //< 待機している物体の動き得る範囲 (オブジェクト ID を登録する)
+                std::vector<std::size_t>  m_parked_candidates; //< m_parked_hash への問い合わせの結果
+                std::size_t               m_n_parked;          //< 待機している物体の数
+                double                    m_parked_speed;      //< 待機している物体の速さの上限 [px/s]
+                double                    m_park_dt;           //< 待機している間の tick の時間刻み [s]
+                unsigned long             m_collision_tick;    //< 最後に collide_movable_objects() で空間ハッシュを構築した tick
+
+                // 衝突し得る組の検出 (broad phase と円同士の重なり判定) と衝突規則の判定をワーカーで分担する
+                WorkerPool                 m_workers;
+                std::vector<DetectBuffer>  m_detect_buffers; //< ワーカーごとの領域 (0 番は逐次処理の作業領域も兼ねる)
+                std::vector<Detection>     m_detections;     //< movable 物体の添字で引く
+                std::vector<unsigned char> m_detect_changed_flags; //< 検出の後で状態が変化した物体
+
+                // 島ごとに衝突の計算 (resolve) をワーカーで分担する
+                std::vector<std::size_t>   m_island_ids;     //< movable 物体の属する島 (NO_ISLAND なら島に属さない)
+                std::vector<Island>        m_islands;
+                std::vector<std::size_t>   m_island_members; //< 島ごとに物体の添字を昇順に並べる
+                std::vector<std::pair<std::size_t, std::size_t> > m_island_order; //< (見積もり, 島)．並列に計算する島を重い順に並べ，その後ろに残りの島を置く
+                std::vector<unsigned char> m_island_done;    //< collide_island_boundaries() で調べ終えた物体
+                bool                       m_resolving_islands; //< 島ごとの衝突の計算中
+
+                // fixed-movable 間の衝突計算 (broad phase) に利用する
+                AABBTree                  m_fixed_tree;
+                bool                      m_fixed_tree_valid;
+                std::vector<std::size_t>  m_fixed_unbounded; //< 矩形を持たない fixed 物体 (Field など) の添字
+                std::vector<std::size_t>  m_fixed_slots; //< fixed 物体の CircleStore 上のスロット
+
+                // ForceField をまとめた格子 (空なら ForceField も他の fixed 物体と同様に扱う)
+                ForceGrid                         m_force_grid;
+                std::vector<const ForceField *>   m_force_fields; //< 格子にまとめた ForceField
+                double                            m_force_reach;  //< 格子による力が ForceField の円の外に及び得る距離 [px]
         };
 
         inline Manager::State
@@ -101,11 +446,108 @@ namespace DropletCollection
             m_state = state;
         }
 
+        /**
+         * @brief movable 物体 @c index が，衝突計算の開始時に休眠していたかどうか
+         */
+        inline bool
+        Manager::was_asleep (const std::size_t index) const
+        {
+            return index < m_collision_asleep.size() && m_collision_asleep[index];
+        }
+
+        /**
+         * @brief movable 物体同士の衝突を島ごとに分担して計算するかどうか
+         *
+         *  ENGINE_EVENT では，衝突の計算中に待機している物体の時間発展を再開することがあるので，
+         * 島には分けない．
+         */
+        inline bool
+        Manager::uses_islands () const
+        {
+            return m_island_enabled && m_engine != ENGINE_EVENT;
+        }
+
+        /**
+         * @brief movable 物体 @c index が待機している (ENGINE_EVENT で時間発展を止めている) かどうか
+         */
+        inline bool
+        Manager::is_parked (const std::size_t index) const
+        {
+            const unsigned int id = m_movable_objects[index]->get_id();
+
+            return id < m_parked.size() && m_parked[id].parked;
+        }
+
+        /**
+         * @brief 島ごとの衝突の計算中に，movable 物体 @c other が @c index と同じ島に属するかどうか
+         *
+         *  島ごとの計算中でなければ常に true を返す．
+         */
+        inline bool
+        Manager::in_island (const std::size_t index,
+                            const std::size_t other) const
+        {
+            return ! m_resolving_islands || m_island_ids[other] == m_island_ids[index];
+        }
+
+        /**
+         * @brief 物体の移動と衝突判定の方式を返す (initialize() で決まる)
+         */
+        inline Manager::Engine
+        Manager::get_engine () const
+        {
+            return m_engine;
+        }
+
+        /**
+         * @brief これまでに simulate() で進めた tick 数を返す (tick の初めに 1 進む)
+         */
+        inline unsigned long
+        Manager::get_tick () const
+        {
+            return m_tick;
+        }
+
+        /**
+         * @brief 現在 (最後) の simulate() で進めている時間刻み [s] を返す
+         *
+         *  衝突規則など，simulate() の中で呼び出される処理が時間刻みを得るのに使う．
+         */
+        inline double
+        Manager::get_time_step () const
+        {
+            return m_time_step;
+        }
+
+        inline ContactSet&
+        Manager::get_contacts ()
+        {
+            return m_contacts;
+        }
+
+        inline const ContactSet&
+        Manager::get_contacts () const
+        {
+            return m_contacts;
+        }
+
+        inline ObjectPool&
+        Manager::get_object_pool ()
+        {
+            return m_object_pool;
+        }
+
+        inline CircleStore&
+        Manager::get_circle_store ()
+        {
+            return m_circle_store;
+        }
+
         template <class ChildT>
         inline ChildT *
         Manager::attach ()
         {
-            ChildT *p = new ChildT (*this);
+            ChildT *p = new (*this) ChildT (*this);
             attach_internal(p);
             return p;
         }
@@ -114,7 +556,7 @@ namespace DropletCollection
         inline ChildT *
         Manager::attach (const ChildT& other)
         {
-            ChildT *p = new ChildT (*this, other);
+            ChildT *p = new (*this) ChildT (*this, other);
             attach_internal(p);
             return p;
         }
@@ -21,21 +21,22 @@
 
 #include <ctime>
 #include "error.hpp"
+#include "object-manager.hpp"
 #include "object-objectbase.hpp"
 
 namespace DropletCollection
 {
     namespace Object
     {
-        std::bitset<ObjectBase::N_OBJECTS> ObjectBase::m_object_flags(0);
-
         ObjectBase::ObjectBase (Manager&   manager,
                                 const bool movable)
             : m_class(0),
               m_manager(manager),
-              m_id(get_object_id()),
+              m_id(manager.allocate_object_id()),
               m_movable(movable),
               m_alive(true),
+              m_advanceable(true),
+              m_spawner(false),
               m_name("")
         {
         }
@@ -44,111 +45,281 @@ namespace DropletCollection
                                 const ObjectBase& other)
             : m_class(other.m_class),
               m_manager(manager),
-              m_id(get_object_id()),
+              m_id(manager.allocate_object_id()),
               m_movable(other.m_movable),
               m_alive(other.m_alive),
+              m_advanceable(other.m_advanceable),
+              m_spawner(other.m_spawner),
               m_name(other.m_name)
         {
         }
 
         ObjectBase::~ObjectBase ()
         {
-            m_object_flags &= ~m_id; // 使用中のオブジェクト ID を使用可能に設定する
+            m_manager.release_object_id(m_id); // 使用中のオブジェクト ID を使用可能に設定する
             dc_log("オブジェクト '%s' を解放しました", m_name.c_str());
         }
 
-        std::bitset<ObjectBase::N_OBJECTS>
-        ObjectBase::get_object_id ()
+        void *
+        ObjectBase::operator new (const std::size_t size,
+                                  Manager&          manager)
         {
-            for( std::size_t i = 0; i < N_OBJECTS; ++i )
-            {
-                if( ! m_object_flags.test(i) ) // i ビット目を使用することができる
-                {
-                    m_object_flags.set(i); // i ビット目を使用中に設定する
+            return manager.get_object_pool().allocate(size);
+        }
 
-                    std::bitset<N_OBJECTS> id;
-                    id.set(i);
-                    return id; // i ビット目のみが 1 のビット列をオブジェクトIDとして返す
-                }
-            }
+        // コンストラクタが例外を投げた場合に呼び出される
+        void
+        ObjectBase::operator delete (void * const p,
+                                     Manager&)
+        {
+            ObjectPool::deallocate(p);
+        }
 
-            dc_log("割り当て可能なオブジェクト ID が存在しません");
-            std::exit(EXIT_FAILURE);
+        void
+        ObjectBase::operator delete (void * const p)
+        {
+            ObjectPool::deallocate(p);
         }
 
+        /**
+         * @brief 物体を時間 @c dt [s] だけ進める
+         */
         void
-        ObjectBase::advance ()
+        ObjectBase::advance (const double dt G_GNUC_UNUSED)
         {
-            m_prev_collided = m_curr_collided;
-            m_curr_collided = 0;
+            // Nothing to do. (衝突の記録は Manager が tick ごとに切り替える)
         }
 
+        /**
+         * @brief 直前の tick (または現在の tick の前の段階) で @c other と衝突していたかどうか
+         *
+         * @see ContactSet::begin_pass()
+         */
+        bool
+        ObjectBase::is_collided (const ObjectBase& other) const
+        {
+            return m_manager.get_contacts().was_collided(m_id, other.m_id);
+        }
+
+        /**
+         * @brief 直前の tick における @c other との接触の情報を @c contact に格納する
+         *
+         *  法線はこの物体から @c other へ向かう向きにそろえる．
+         *
+         * @return 直前の tick で衝突していなければ false を返す．
+         */
+        bool
+        ObjectBase::get_contact (const ObjectBase&     other,
+                                 ContactSet::Contact& contact) const
+        {
+            const ContactSet::Contact * const previous = m_manager.get_contacts().find_previous(m_id, other.m_id);
+
+            if( previous == 0 ) return false;
+
+            contact = *previous;
+            if( m_id > other.m_id ) contact.normal = -contact.normal;
+
+            return true;
+        }
+
+        /**
+         * @brief 現在の tick における @c other との接触の情報を記録する (衝突規則から呼び出す)
+         *
+         *  @c normal はこの物体から @c other へ向かう単位ベクトル，@c depth はめり込みの深さ，
+         * @c feature は接触した部分の番号である．記録は次の tick に get_contact() で参照できる．
+         */
         void
+        ObjectBase::record_contact (const ObjectBase&     other,
+                                    const Vector<double>& normal,
+                                    const double          depth,
+                                    const int             feature) const
+        {
+            m_manager.get_contacts().record(m_id, other.m_id, (m_id < other.m_id) ? normal : -normal, depth, feature);
+        }
+
+        /**
+         * @brief 物体を囲む矩形を取得する
+         *
+         *  衝突判定の候補を絞り込むために利用する．矩形を定義できない物体 (Field など) は
+         * false を返し，全ての物体と衝突判定を行う．
+         */
+        bool
+        ObjectBase::get_bounding_box (BoundingBox& box G_GNUC_UNUSED) const
+        {
+            return false;
+        }
+
+        /**
+         * @brief 矩形 @c box の中にある物体が，この物体と接触するまでの隙間を求める
+         *
+         *  隙間は，@c box の辺がどれだけ動けば接触し得るかの下限 (座標軸ごと) である．
+         * 既定では矩形同士の距離を返す．矩形を定義できない物体は，隙間を求められる
+         * ものだけが再定義する．求められない場合は false を返す．
+         */
+        bool
+        ObjectBase::get_clearance (const BoundingBox& box,
+                                   double&            clearance) const
+        {
+            BoundingBox own;
+
+            if( ! get_bounding_box(own) ) return false;
+
+            clearance = own.get_gap(box);
+            return true;
+        }
+
+        /**
+         * @brief Globule @c other の円が位置 @c start から @c motion だけ直線的に移動する間に，
+         *        この物体と初めて接触する時刻を求める (連続衝突判定)
+         *
+         *  時刻は @c motion に対する割合 (0 以上 1 以下) で @c toi に格納する．移動の初めに
+         * 既に接触している場合や，連続衝突判定に対応していない物体は false を返し，
+         * 離散的な衝突判定に任せる．
+         */
+        bool
+        ObjectBase::sweep (const Globule&        other G_GNUC_UNUSED,
+                           const Vector<double>& start G_GNUC_UNUSED,
+                           const Vector<double>& motion G_GNUC_UNUSED,
+                           double&               toi G_GNUC_UNUSED) const
+        {
+            return false;
+        }
+
+        /**
+         * @brief 移動の初めと終わりにおける，円と平面 (直線) の間の隙間から接触する時刻を求める
+         *
+         *  隙間は離れているときに正となる符号付き距離である．初めに離れていて (正)，
+         * 終わりに接触している (0 以下) ときだけ，線形補間した時刻を @c toi に格納して
+         * true を返す．
+         */
+        bool
+        ObjectBase::sweep_gap (const double start_gap,
+                               const double end_gap,
+                               double&      toi)
+        {
+            if( start_gap <= 0.0 || end_gap > 0.0 ) return false;
+
+            toi = start_gap / (start_gap - end_gap);
+            return true;
+        }
+
+        /**
+         * @brief @c other との間に (衝突しないという規則ではない) 衝突規則が存在するかどうか
+         */
+        bool
+        ObjectBase::has_rule (const ObjectBase& other) const
+        {
+            dc_return_val_if_fail(m_class != 0, false);
+            dc_return_val_if_fail(other.m_class != 0, false);
+
+            const Dispatch& dispatch = m_dispatch[m_class->index][other.m_class->index];
+
+            return dispatch.defined && ( dispatch.collide != 0 || dispatch.respond != 0 );
+        }
+
+        /**
+         * @brief 衝突規則に従って @c other との衝突を計算する
+         *
+         *  検出と応答に分けた規則では，detect() で接触を検出してから respond() で応答する．
+         *
+         * @return 衝突したなら true を返す．
+         */
+        bool
         ObjectBase::collide (ObjectBase& other)
         {
-            std::list<VTable>::const_iterator it;
-            unsigned int score, max_score = 0;
-            const VTable *vtable = 0;
-            bool matched, reversed = false, vt_reversed = false;
+            dc_return_val_if_fail(get_alive(), false);
+            dc_return_val_if_fail(other.get_alive(), false);
+            dc_return_val_if_fail(m_class != 0, false);
+            dc_return_val_if_fail(other.m_class != 0, false);
 
-            dc_return_if_fail(get_alive());
-            dc_return_if_fail(other.get_alive());
-            dc_return_if_fail(m_class != 0);
-            dc_return_if_fail(other.m_class != 0);
+            const Dispatch& dispatch = m_dispatch[m_class->index][other.m_class->index];
 
-            // スコアが最大となる衝突規則を検索する
-            for( it = m_vtable_list.begin(); it != m_vtable_list.end(); ++it )
+            if( dispatch.defined ) // 衝突規則が見つかった
             {
-                if( (m_class->flags & it->self.mask).any() &&
-                    (other.m_class->flags & it->other.mask).any() )
-                {
-                    reversed = false;
-                    matched  = true;
-                }
-                else if( (m_class->flags & it->other.mask).any() &&
-                         (other.m_class->flags & it->self.mask).any() )
+                if( dispatch.respond != 0 ) // 検出と応答に分けた規則
                 {
-                    reversed = true;
-                    matched  = true;
-                }
-                else
-                {
-                    matched = false;
+                    Manifold manifold;
+                    return detect(other, manifold) == DETECT_TOUCHING && respond(other, manifold);
                 }
 
-                if( matched )
-                {
-                    // 派生クラスの末端側ほどスコアが高くなる
-                    score = it->self.flags.count() + it->other.flags.count();
-                    if( score > max_score )
-                    {
-                        vt_reversed = reversed;
-                        max_score = score;
-                        vtable = &(*it);
-                    }
-                }
-            }
-
-            if( vtable != 0 ) // 衝突規則が見つかった
-            {
-                if( vtable->collide == 0 ) return; // 決して衝突しない物体間の規則
+                if( dispatch.collide == 0 ) return false; // 決して衝突しない物体間の規則
 
                 bool res;
-                if( vt_reversed ) res = ( *(vtable->collide) )(other, *this);
-                else              res = ( *(vtable->collide) )(*this, other);
+                if( dispatch.reversed ) res = ( *(dispatch.collide) )(other, *this);
+                else                    res = ( *(dispatch.collide) )(*this, other);
 
                 if( res )
                 {
-                    // 衝突した物体の ID を記憶しておく
-                    m_curr_collided       |= other.m_id;
-                    other.m_curr_collided |= m_id;
+                    // 衝突した物体の ID の組を記憶しておく
+                    m_manager.get_contacts().insert(m_id, other.m_id);
                 }
+
+                return res;
             }
             else
             {
                 dc_error("衝突規則が定義されていません '%s' <=> '%s'",
                          m_class->name.c_str(), other.m_class->name.c_str());
             }
+
+            return false;
+        }
+
+        /**
+         * @brief 衝突規則に従って @c other との接触を検出し，接触の情報を @c manifold に格納する
+         *
+         *  どちらの物体の状態も変更しないので，ワーカースレッドから並列に呼び出せる．
+         * 結果が DETECT_TOUCHING なら，両者の状態が変わらないうちに respond() に渡すと
+         * collide() と同じ結果になる．DETECT_SEPARATED なら collide() は何もしない．
+         */
+        ObjectBase::DetectResult
+        ObjectBase::detect (const ObjectBase& other,
+                            Manifold&         manifold) const
+        {
+            dc_return_val_if_fail(m_class != 0, DETECT_SEPARATED);
+            dc_return_val_if_fail(other.m_class != 0, DETECT_SEPARATED);
+
+            const Dispatch& dispatch = m_dispatch[m_class->index][other.m_class->index];
+
+            if( ! dispatch.defined ) return DETECT_DEFERRED; // collide() が報告する
+            if( dispatch.respond == 0 ) return dispatch.collide == 0 ? DETECT_SEPARATED : DETECT_DEFERRED;
+
+            bool touching;
+            if( dispatch.reversed ) touching = ( *(dispatch.detect) )(other, *this, manifold);
+            else                    touching = ( *(dispatch.detect) )(*this, other, manifold);
+
+            return touching ? DETECT_TOUCHING : DETECT_SEPARATED;
+        }
+
+        /**
+         * @brief detect() で検出した接触 @c manifold に対して，衝突規則に従って応答する
+         *
+         * @return 衝突したなら true を返す．
+         */
+        bool
+        ObjectBase::respond (ObjectBase&     other,
+                             const Manifold& manifold)
+        {
+            dc_return_val_if_fail(get_alive(), false);
+            dc_return_val_if_fail(other.get_alive(), false);
+            dc_return_val_if_fail(m_class != 0, false);
+            dc_return_val_if_fail(other.m_class != 0, false);
+
+            const Dispatch& dispatch = m_dispatch[m_class->index][other.m_class->index];
+
+            dc_return_val_if_fail(dispatch.respond != 0, false);
+
+            bool res;
+            if( dispatch.reversed ) res = ( *(dispatch.respond) )(other, *this, manifold);
+            else                    res = ( *(dispatch.respond) )(*this, other, manifold);
+
+            if( res )
+            {
+                // 衝突した物体の ID の組を記憶しておく
+                m_manager.get_contacts().insert(m_id, other.m_id);
+            }
+
+            return res;
         }
 
         /**********************************************************************
@@ -158,6 +329,24 @@ namespace DropletCollection
         std::list<ObjectBase::ClassInfo>   ObjectBase::m_class_list;
         std::list<ObjectBase::VTable>      ObjectBase::m_vtable_list;
         std::bitset<ObjectBase::N_CLASSES> ObjectBase::m_class_mask(1);
+        ObjectBase::Dispatch               ObjectBase::m_dispatch[N_CLASSES][N_CLASSES];
+        const std::string                  ObjectBase::m_unknown_class;
+
+        /**
+         * @brief クラス名に対応する識別子を取得する
+         *
+         *  未登録のクラスは仮登録される (後で本登録されても識別子は変わらない)．
+         * 毎 tick 呼び出される処理では，文字列の比較を避けるために識別子を保存しておくこと．
+         */
+        ObjectBase::ClassId
+        ObjectBase::intern_class (const std::string& class_name)
+        {
+            ClassInfo *info = find_class_info(class_name);
+
+            if( info == 0 ) info = add_class_info(class_name);
+
+            return info;
+        }
 
         bool
         ObjectBase::is (const std::string& class_name) const
@@ -191,11 +380,14 @@ namespace DropletCollection
             {
                 info->mask  = m_class_mask;
                 info->flags = m_class_mask;
+                for( info->index = 0; ! info->mask.test(info->index); ++info->index ) ;
                 if( m_class != 0 ) info->flags |= m_class->flags;
                 m_class_mask <<= 1;
 
                 std::cerr << "\tmask  = " << info->mask << std::endl;
                 std::cerr << "\tflags = " << info->flags << std::endl;
+
+                update_dispatch();
             }
 
             m_class = info;
@@ -215,11 +407,115 @@ namespace DropletCollection
             if( info == 0 ) info = add_class_info(other_class); // 衝突相手のクラスが未登録なら，仮登録する
 
             // VTable を登録する
-            VTable vtable = {*m_class, *info, collide_func};
+            VTable vtable = {*m_class, *info, collide_func, 0, 0};
             m_vtable_list.push_back(vtable);
 
             dc_log("衝突規則を登録しました '%s' <=> '%s'",
                    m_class->name.c_str(), info->name.c_str());
+
+            update_dispatch();
+        }
+
+        /**
+         * @brief 接触の検出 @c detect_func と応答 @c respond_func に分けた衝突規則を登録する
+         *
+         * @c detect_func は物体の状態を変更してはならない (ObjectBase::detect() を参照)．
+         */
+        void
+        ObjectBase::register_function (const std::string& other_class,
+                                       const DetectFunc   detect_func,
+                                       const RespondFunc  respond_func)
+        {
+            ClassInfo *info;
+
+            dc_return_if_fail(m_class != 0);
+            dc_return_if_fail(detect_func != 0 && respond_func != 0);
+
+            info = find_class_info(other_class); // 衝突相手のクラスを探す
+            if( info == 0 ) info = add_class_info(other_class); // 衝突相手のクラスが未登録なら，仮登録する
+
+            // VTable を登録する
+            VTable vtable = {*m_class, *info, 0, detect_func, respond_func};
+            m_vtable_list.push_back(vtable);
+
+            dc_log("衝突規則を登録しました '%s' <=> '%s' (検出と応答)",
+                   m_class->name.c_str(), info->name.c_str());
+
+            update_dispatch();
+        }
+
+        /**
+         * @brief 全てのクラスの組について，適用する衝突規則を求めて m_dispatch に記録する
+         *
+         *  クラスの組 (self, other) に適用されるのは，両者に当てはまる規則のうち，
+         * 規則の両辺のクラスがより派生側にある (スコアが最大の) ものである．
+         * スコアが等しい規則が複数あれば，先に登録されたものを優先する．
+         * 規則やクラスが登録されるたびに呼び出される．
+         */
+        void
+        ObjectBase::update_dispatch ()
+        {
+            std::list<ClassInfo>::const_iterator sit, oit;
+            std::list<VTable>::const_iterator it;
+
+            for( std::size_t i = 0; i < N_CLASSES; ++i )
+            {
+                for( std::size_t j = 0; j < N_CLASSES; ++j )
+                {
+                    Dispatch undefined = {0, 0, 0, false, false};
+                    m_dispatch[i][j] = undefined;
+                }
+            }
+
+            for( sit = m_class_list.begin(); sit != m_class_list.end(); ++sit )
+            {
+                if( ! sit->mask.any() ) continue; // 仮登録のクラス
+
+                for( oit = m_class_list.begin(); oit != m_class_list.end(); ++oit )
+                {
+                    if( ! oit->mask.any() ) continue; // 仮登録のクラス
+
+                    Dispatch& dispatch = m_dispatch[sit->index][oit->index];
+                    unsigned int score, max_score = 0;
+                    bool matched, reversed = false;
+
+                    // スコアが最大となる衝突規則を検索する
+                    for( it = m_vtable_list.begin(); it != m_vtable_list.end(); ++it )
+                    {
+                        if( (sit->flags & it->self.mask).any() &&
+                            (oit->flags & it->other.mask).any() )
+                        {
+                            reversed = false;
+                            matched  = true;
+                        }
+                        else if( (sit->flags & it->other.mask).any() &&
+                                 (oit->flags & it->self.mask).any() )
+                        {
+                            reversed = true;
+                            matched  = true;
+                        }
+                        else
+                        {
+                            matched = false;
+                        }
+
+                        if( matched )
+                        {
+                            // 派生クラスの末端側ほどスコアが高くなる
+                            score = it->self.flags.count() + it->other.flags.count();
+                            if( score > max_score )
+                            {
+                                max_score = score;
+                                dispatch.collide  = it->collide;
+                                dispatch.detect   = it->detect;
+                                dispatch.respond  = it->respond;
+                                dispatch.reversed = reversed;
+                                dispatch.defined  = true;
+                            }
+                        }
+                    }
+                }
+            }
         }
 
         ObjectBase::ClassInfo *
@@ -237,7 +533,7 @@ namespace DropletCollection
         ObjectBase::ClassInfo *
         ObjectBase::add_class_info (const std::string& name)
         {
-            ClassInfo info = {name, 0, 0};
+            ClassInfo info = {name, 0, 0, 0};
 
             m_class_list.push_back(info);
 
@@ -262,5 +558,24 @@ namespace DropletCollection
 
             return m_rand;
         }
+
+        /**********************************************************************
+         *  時間の単位
+         *********************************************************************/
+
+        const double ObjectBase::m_reference_time_step = 0.035;
+
+        /**
+         * @brief ステージ設定ファイルの値が前提とする 1 tick の長さ [s] を返す
+         *
+         *  ステージ設定ファイルの速度や力は，1 tick をこの長さとした「1 tick あたり」の値で
+         * 書かれている．読み込むときに秒あたりの値に換算し，シミュレーションは任意の
+         * 時間刻みで進める．
+         */
+        double
+        ObjectBase::get_reference_time_step ()
+        {
+            return m_reference_time_step;
+        }
     }
 }
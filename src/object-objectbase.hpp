@@ -27,25 +27,66 @@
 #include <bitset>
 #include <glibmm/random.h>
 #include <cairomm/cairomm.h>
+#include "boundingbox.hpp"
 #include "settingfile.hpp"
+#include "vector.hpp"
+#include "object-contactset.hpp"
 
 namespace DropletCollection
 {
     namespace Object
     {
         class Manager;
+        class Globule;
 
         class ObjectBase
         {
+            private:
+                struct ClassInfo;
+
             public:
+                /// クラスを表す識別子 (intern_class() で取得する．比較は整数演算のみで行える)
+                typedef const ClassInfo * ClassId;
+
+                /**
+                 * @brief 衝突規則が検出した接触の情報 (detect() で求め，respond() に渡す)
+                 *
+                 *  法線の向きは，規則の 2 つ目の引数から 1 つ目の引数へ向かう向きである．
+                 * 規則によっては一部の値を使わない．
+                 */
+                struct Manifold
+                {
+                    Vector<double> normal;   //< 接触点の法線 (単位ベクトル)
+                    double         distance; //< めり込みの深さ [px]
+                    int            feature;  //< 接触した部分の番号 (Polygon の辺など，なければ -1)
+                };
+
+                /// detect() の結果
+                enum DetectResult
+                {
+                    DETECT_SEPARATED, //< 接触していない (応答は何もしない)
+                    DETECT_TOUCHING,  //< 接触している (respond() で応答する)
+                    DETECT_DEFERRED   //< 検出と応答に分かれていない規則 (collide() で計算する)
+                };
+
                          ObjectBase (Manager&          manager,
                                      bool              movable);
                          ObjectBase (Manager&          manager,
                                      const ObjectBase& other);
                 virtual ~ObjectBase ();
 
+                // 物体は所属する Manager のメモリプールに確保する
+                static void * operator new    (std::size_t size,
+                                               Manager&    manager);
+                static void   operator delete (void       *p,
+                                               Manager&    manager);
+                static void   operator delete (void       *p);
+
                 static Glib::Rand&        get_random   ();
-                inline std::string        get_class    () const;
+                static double             get_reference_time_step ();
+                static ClassId            intern_class (const std::string& class_name);
+                inline const std::string& get_class    () const;
+                inline ClassId            get_class_id () const;
                 inline Manager&           get_manager  ();
                 inline const Manager&     get_manager  () const;
                 inline bool               get_movable  () const;
@@ -53,32 +94,69 @@ namespace DropletCollection
                 inline const std::string& get_name     () const;
                 inline void               set_name     (const std::string& name);
                 bool                      is           (const std::string& class_name) const;
-                inline bool               is_collided  (const ObjectBase& other) const;
+                inline bool               is           (ClassId class_id) const;
+                inline unsigned int       get_id       () const;
+                bool                      is_collided  (const ObjectBase& other) const;
+                bool                      get_contact  (const ObjectBase&     other,
+                                                        ContactSet::Contact& contact) const;
+                bool                      has_rule     (const ObjectBase& other) const;
 
                 // For DropletCollection::Object::Manager
-                virtual void load    (const SettingFile& file) = 0;
-                virtual void draw    (const Cairo::RefPtr<Cairo::Context>& cr) const = 0;
-                virtual void advance ();
-                void         collide (ObjectBase& other);
+                virtual void load             (const SettingFile& file) = 0;
+                virtual void draw             (const Cairo::RefPtr<Cairo::Context>& cr,
+                                               double                               alpha) const = 0;
+                virtual void advance          (double dt);
+                inline bool  get_advanceable  () const;
+                inline bool  get_spawner      () const;
+                virtual bool get_bounding_box (BoundingBox& box) const;
+                virtual bool get_clearance    (const BoundingBox& box,
+                                               double&            clearance) const;
+                virtual bool sweep            (const Globule&        other,
+                                               const Vector<double>& start,
+                                               const Vector<double>& motion,
+                                               double&               toi) const;
+                DetectResult detect           (const ObjectBase& other,
+                                               Manifold&         manifold) const;
+                bool         respond          (ObjectBase&     other,
+                                               const Manifold& manifold);
+                bool         collide          (ObjectBase& other);
 
             protected:
                 typedef bool (* CollideFunc) (ObjectBase& self,
                                               ObjectBase& other);
+                typedef bool (* DetectFunc)  (const ObjectBase& self,
+                                              const ObjectBase& other,
+                                              Manifold&         manifold);
+                typedef bool (* RespondFunc) (ObjectBase&     self,
+                                              ObjectBase&     other,
+                                              const Manifold& manifold);
 
                 inline void set_alive         (bool alive);
+                inline void set_advanceable   (bool advanceable);
+                inline void set_spawner       (bool spawner);
+                static bool sweep_gap         (double  start_gap,
+                                               double  end_gap,
+                                               double& toi);
+                void        record_contact    (const ObjectBase&     other,
+                                               const Vector<double>& normal,
+                                               double                depth,
+                                               int                   feature = -1) const;
                 bool        register_class    (const std::string& self_class);
                 void        register_function (const std::string& other_class,
                                                CollideFunc        collide_func);
+                void        register_function (const std::string& other_class,
+                                               DetectFunc         detect_func,
+                                               RespondFunc        respond_func);
 
             private:
                 enum { N_CLASSES = 32 };
-                enum { N_OBJECTS = 128 }; // 同時に構築できるオブジェクト数の上限値
 
                 struct ClassInfo
                 {
                     std::string            name;
                     std::bitset<N_CLASSES> mask;
                     std::bitset<N_CLASSES> flags;
+                    std::size_t            index; //< mask の立っているビットの位置 (仮登録中は未定義)
                 };
 
                 struct VTable
@@ -86,42 +164,73 @@ namespace DropletCollection
                     const ClassInfo& self;
                     const ClassInfo& other;
                     CollideFunc      collide;
+                    DetectFunc       detect;
+                    RespondFunc      respond;
+                };
+
+                // クラスの組に対して適用する衝突規則 (m_vtable_list から事前に解決したもの)
+                struct Dispatch
+                {
+                    CollideFunc collide;
+                    DetectFunc  detect;   //< 検出と応答に分けた規則 (respond とともに 0 でなければ collide は使わない)
+                    RespondFunc respond;
+                    bool        reversed; //< 引数を入れ替えて規則を呼び出す
+                    bool        defined;  //< 衝突規則が存在する
                 };
 
                 ObjectBase (); // Do not call!
                 ObjectBase (const ObjectBase& other); // Do not call!
                 ObjectBase& operator = (const ObjectBase& other); // Do not call!
 
-                static ClassInfo            * find_class_info (const std::string& name);
-                static ClassInfo            * add_class_info  (const std::string& name);
-                static std::bitset<N_OBJECTS> get_object_id   ();
+                static ClassInfo * find_class_info (const std::string& name);
+                static ClassInfo * add_class_info  (const std::string& name);
+                static void        update_dispatch ();
 
                 static std::list<ClassInfo>   m_class_list;
                 static std::list<VTable>      m_vtable_list;
+                static Dispatch               m_dispatch[N_CLASSES][N_CLASSES]; //< [self][other]
                 static std::bitset<N_CLASSES> m_class_mask;
-                static std::bitset<N_OBJECTS> m_object_flags; //使用中のオブジェクトIDに対応するビットは1になる
+                static const std::string      m_unknown_class;
                 static Glib::Rand             m_rand;
                 static bool                   m_rand_inited;
+                static const double           m_reference_time_step;
 
-                ClassInfo                  * m_class;
-                Manager&                     m_manager;
-                const std::bitset<N_OBJECTS> m_id;
-                std::bitset<N_OBJECTS>       m_prev_collided;
-                std::bitset<N_OBJECTS>       m_curr_collided;
-                const bool                   m_movable;
-                bool                         m_alive;
-                std::string                  m_name;
+                ClassInfo        * m_class;
+                Manager&           m_manager;
+                const unsigned int m_id; //< Manager 内で一意なオブジェクト ID
+                const bool         m_movable;
+                bool               m_alive;
+                bool               m_advanceable; //< advance() を呼び出す必要がある
+                bool               m_spawner;     //< 衝突によって物体を追加し得る
+                std::string        m_name;
         };
 
-        inline
-        std::string
+        inline const std::string&
         ObjectBase::get_class () const
         {
-            dc_return_val_if_fail(m_class != 0, "");
+            dc_return_val_if_fail(m_class != 0, m_unknown_class);
 
             return m_class->name;
         }
 
+        inline ObjectBase::ClassId
+        ObjectBase::get_class_id () const
+        {
+            return m_class;
+        }
+
+        /**
+         * @brief 物体が @c class_id のクラス (またはその派生クラス) に属するかどうか
+         */
+        inline bool
+        ObjectBase::is (const ClassId class_id) const
+        {
+            dc_return_val_if_fail(m_class != 0, false);
+            dc_return_val_if_fail(class_id != 0, false);
+
+            return (m_class->flags & class_id->mask).any();
+        }
+
         inline
         Manager&
         ObjectBase::get_manager ()
@@ -153,6 +262,38 @@ namespace DropletCollection
             m_alive = alive;
         }
 
+        inline bool
+        ObjectBase::get_advanceable () const
+        {
+            return m_advanceable;
+        }
+
+        /**
+         * @brief advance() で何もしない物体は false を設定する (Manager が呼び出しを省略する)
+         */
+        inline void
+        ObjectBase::set_advanceable (const bool advanceable)
+        {
+            m_advanceable = advanceable;
+        }
+
+        inline bool
+        ObjectBase::get_spawner () const
+        {
+            return m_spawner;
+        }
+
+        /**
+         * @brief 衝突によって物体を追加し得る物体は true を設定する
+         *
+         *  Manager はこの物体を含む組の衝突を，他の組と並列に計算しない．
+         */
+        inline void
+        ObjectBase::set_spawner (const bool spawner)
+        {
+            m_spawner = spawner;
+        }
+
         inline const std::string&
         ObjectBase::get_name () const
         {
@@ -165,10 +306,10 @@ namespace DropletCollection
             m_name = name;
         }
 
-        inline bool
-        ObjectBase::is_collided (const ObjectBase& other) const
+        inline unsigned int
+        ObjectBase::get_id () const
         {
-            return (m_prev_collided & other.m_id).any();
+            return m_id;
         }
     }
 }
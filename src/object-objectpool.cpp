@@ -0,0 +1,145 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include "error.hpp"
+#include "object-objectpool.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        ObjectPool::ObjectPool ()
+            : m_chunk_index(0),
+              m_chunk_used(0),
+              m_n_live(0),
+              m_n_fallback(0)
+        {
+            for( std::size_t i = 0; i < N_SIZE_CLASSES; ++i ) m_free_lists[i] = 0;
+        }
+
+        ObjectPool::~ObjectPool ()
+        {
+            dc_warn_if_fail(m_n_live == 0);
+
+            for( std::size_t i = 0; i < m_chunks.size(); ++i ) delete [] m_chunks[i];
+        }
+
+        /**
+         * @brief @c size バイトの領域を確保する
+         *
+         *  大きすぎる要求は通常の operator new で確保する．
+         */
+        void *
+        ObjectPool::allocate (const std::size_t size)
+        {
+            const std::size_t size_class = (size + HEADER_SIZE + ALIGNMENT - 1) / ALIGNMENT - 1;
+            char *block;
+
+            if( size_class < N_SIZE_CLASSES )
+            {
+                if( m_free_lists[size_class] != 0 ) // 解放済みのブロックを再利用する
+                {
+                    block = reinterpret_cast<char *>(m_free_lists[size_class]);
+                    m_free_lists[size_class] = m_free_lists[size_class]->next;
+                }
+                else
+                {
+                    block = carve((size_class + 1) * ALIGNMENT);
+                }
+            }
+            else
+            {
+                block = static_cast<char *>(::operator new(HEADER_SIZE + size));
+                ++m_n_fallback;
+            }
+
+            Header *header = reinterpret_cast<Header *>(block);
+            header->pool = this;
+            header->size_class = std::min<std::size_t>(size_class, N_SIZE_CLASSES);
+
+            ++m_n_live;
+            return block + HEADER_SIZE;
+        }
+
+        /**
+         * @brief allocate() で確保した領域を確保元のプールへ返す
+         */
+        void
+        ObjectPool::deallocate (void * const p)
+        {
+            if( p == 0 ) return;
+
+            char *block = static_cast<char *>(p) - HEADER_SIZE;
+            const Header *header = reinterpret_cast<const Header *>(block);
+            ObjectPool *pool = header->pool;
+            const std::size_t size_class = header->size_class;
+
+            --pool->m_n_live;
+
+            if( size_class < N_SIZE_CLASSES )
+            {
+                FreeBlock *free_block = reinterpret_cast<FreeBlock *>(block);
+                free_block->next = pool->m_free_lists[size_class];
+                pool->m_free_lists[size_class] = free_block;
+            }
+            else
+            {
+                ::operator delete(block);
+            }
+        }
+
+        /**
+         * @brief 全てのブロックを空きに戻す
+         *
+         *  確保中のブロックが残っていてはならない．チャンクは解放せず，以後の確保で先頭から
+         * 再び切り出す．
+         */
+        void
+        ObjectPool::reset ()
+        {
+            dc_return_if_fail(m_n_live == 0);
+
+            for( std::size_t i = 0; i < N_SIZE_CLASSES; ++i ) m_free_lists[i] = 0;
+            m_chunk_index = 0;
+            m_chunk_used = 0;
+        }
+
+        /**
+         * @brief チャンクから @c block_size バイトのブロックを切り出す
+         */
+        char *
+        ObjectPool::carve (const std::size_t block_size)
+        {
+            if( m_chunk_index == m_chunks.size() || m_chunk_used + block_size > CHUNK_SIZE )
+            {
+                // 次のチャンクへ移る (全て使い切っていれば新しく確保する)
+                if( m_chunk_index < m_chunks.size() ) ++m_chunk_index;
+                if( m_chunk_index == m_chunks.size() ) m_chunks.push_back(new char [CHUNK_SIZE]);
+                m_chunk_used = 0;
+            }
+
+            char *block = m_chunks[m_chunk_index] + m_chunk_used;
+            m_chunk_used += block_size;
+            return block;
+        }
+    }
+}
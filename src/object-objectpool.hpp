@@ -0,0 +1,108 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_0BD9C812_4BCF_40D3_A8EA_1CC212BB4EF8
+#define INCLUDE_GUARD_0BD9C812_4BCF_40D3_A8EA_1CC212BB4EF8
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <vector>
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        /**
+         * @brief 物体のためのメモリプール
+         *
+         *  大きさ (16 バイト単位) ごとに空きブロックのリストを持ち，空きがなければ 64KB の
+         * チャンクから切り出す．解放されたブロックは同じ大きさの確保に再利用される．
+         * reset() は全てのブロックを一度に空きに戻す (チャンクは解放せずに再利用する)．
+         *
+         *  各ブロックの先頭には確保元のプールと大きさを記録するので，deallocate() には
+         * プールも大きさも渡す必要はない．
+         */
+        class ObjectPool
+        {
+            public:
+                 ObjectPool ();
+                ~ObjectPool ();
+
+                void *             allocate       (std::size_t size);
+                static void        deallocate     (void *p);
+                void               reset          ();
+                inline std::size_t get_n_live     () const;
+                inline std::size_t get_n_chunks   () const;
+                inline std::size_t get_n_fallback () const;
+
+            private:
+                ObjectPool (const ObjectPool& other); // Do not call!
+                ObjectPool& operator = (const ObjectPool& other); // Do not call!
+
+                enum
+                {
+                    ALIGNMENT      = 16,
+                    HEADER_SIZE    = 16, //< ブロック先頭の Header の領域 (ALIGNMENT の倍数)
+                    CHUNK_SIZE     = 64 * 1024,
+                    N_SIZE_CLASSES = 64  //< プールで扱う最大のブロックは N_SIZE_CLASSES * ALIGNMENT バイト
+                };
+
+                struct Header
+                {
+                    ObjectPool  * pool;
+                    std::size_t   size_class; //< N_SIZE_CLASSES ならプールを通さずに確保した
+                };
+
+                struct FreeBlock
+                {
+                    FreeBlock * next;
+                };
+
+                char * carve (std::size_t block_size);
+
+                std::vector<char *> m_chunks;
+                std::size_t         m_chunk_index; //< 切り出し中のチャンク
+                std::size_t         m_chunk_used;  //< 切り出し中のチャンクの使用済みバイト数
+                FreeBlock         * m_free_lists[N_SIZE_CLASSES];
+                std::size_t         m_n_live;      //< 確保中のブロック数
+                std::size_t         m_n_fallback;  //< プールを通さずに確保したブロック数 (累計)
+        };
+
+        inline std::size_t
+        ObjectPool::get_n_live () const
+        {
+            return m_n_live;
+        }
+
+        inline std::size_t
+        ObjectPool::get_n_chunks () const
+        {
+            return m_chunks.size();
+        }
+
+        inline std::size_t
+        ObjectPool::get_n_fallback () const
+        {
+            return m_n_fallback;
+        }
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_0BD9C812_4BCF_40D3_A8EA_1CC212BB4EF8 */
@@ -20,6 +20,7 @@
 #endif
 
 #include "error.hpp"
+#include "object-manager.hpp"
 #include "object-globule.hpp"
 #include "object-polygon.hpp"
 
@@ -38,17 +39,22 @@ namespace DropletCollection
             if( register_class("Polygon") )
             {
                 register_function("Globule",
-                                  (CollideFunc) &Polygon::collide_with_globule);
+                                  (DetectFunc) &Polygon::detect_globule,
+                                  (RespondFunc) &Polygon::collide_with_globule);
             }
         }
 
         Polygon::Polygon (Manager&       manager,
                           const Polygon& other)
             : ObjectBase(manager, other),
-              m_segm_list(other.m_segm_list),
+              m_edges(other.m_edges),
               m_position(other.m_position),
               m_center(other.m_center),
-              m_radius(0.0),
+              m_radius(other.m_radius),
+              m_box(other.m_box),
+              m_distance_grid(other.m_distance_grid),
+              m_gradient_grid(other.m_gradient_grid),
+              m_show_outline(other.m_show_outline),
               m_image(other.m_image)
         {
         }
@@ -64,11 +70,13 @@ namespace DropletCollection
         {
             std::list<Vector<double> >::const_iterator p1, p2, p3;
             Vector<double> n0, n1, n2;
-            LineSegment lseg;
+            Edge edge;
 
             g_return_val_if_fail(points.size() >= 3, false);
 
-            m_segm_list.clear(); // 古いデータを除去する
+            m_edges.clear(); // 古いデータを除去する
+            m_distance_grid.clear();
+            m_gradient_grid.clear();
             m_radius = 0.0;
 
             m_position = origin; // 原点座標を設定
@@ -94,19 +102,29 @@ namespace DropletCollection
                 if( p3 != points.begin() && fle(Vector<double>::inner_product(n0, n1), 0.0) ) // n0 が定義されている
                 {
                     dc_error("Polygon: 法線ベクトルが矛盾しています Failed 'n0.n1 > 0'");
-                    m_segm_list.clear();
+                    m_edges.clear();
                     return false;
                 }
 
-                lseg.bp   = *p2 + origin;
-                lseg.ep   = *p3 + origin;
-                lseg.norm = n2;
-                m_segm_list.push_back(lseg);
-
-                dc_log("Polygon: append LineSegment {bp:[%g,%g]; ep:[%g,%g]; norm:[%g,%g]}",
-                       lseg.bp.get_x(), lseg.bp.get_y(),
-                       lseg.ep.get_x(), lseg.ep.get_y(),
-                       lseg.norm.get_x(), lseg.norm.get_y());
+                edge.bp     = *p2 + origin;
+                edge.ep     = *p3 + origin;
+                edge.length = (*p3 - *p2).get_size();
+                if( fiszero(edge.length) )
+                {
+                    dc_error("Polygon: 長さ 0 の辺があります");
+                    m_edges.clear();
+                    return false;
+                }
+                edge.dir    = (*p3 - *p2) / edge.length;
+                edge.norm   = edge.dir.get_rotated_p90(); // 辺に厳密に直交させ，向きだけ n2 に合わせる
+                if( Vector<double>::inner_product(edge.norm, n2) < 0.0 ) edge.norm = -edge.norm;
+                m_edges.push_back(edge);
+
+                dc_log("Polygon: append Edge {bp:[%g,%g]; ep:[%g,%g]; norm:[%g,%g]; length:%g}",
+                       edge.bp.get_x(), edge.bp.get_y(),
+                       edge.ep.get_x(), edge.ep.get_y(),
+                       edge.norm.get_x(), edge.norm.get_y(),
+                       edge.length);
             }
 
             calc_bounding_volume(); // バウンディングボリュームを計算する
@@ -117,26 +135,111 @@ namespace DropletCollection
         void
         Polygon::calc_bounding_volume ()
         {
-            std::list<LineSegment>::const_iterator it;
+            std::vector<Edge>::const_iterator it;
             Vector<double> sum(0.0, 0.0);
 
             // 重心を計算する
-            for( it = m_segm_list.begin(); it != m_segm_list.end(); ++it ) sum += it->bp;
-            m_center = sum / m_segm_list.size();
+            for( it = m_edges.begin(); it != m_edges.end(); ++it ) sum += it->bp;
+            m_center = sum / m_edges.size();
 
             // バウンディングボリュームの半径を計算する
             double distance2, max_distance2 = 0.0;
-            for( it = m_segm_list.begin(); it != m_segm_list.end(); ++it )
+            for( it = m_edges.begin(); it != m_edges.end(); ++it )
             {
                 distance2 = m_center.distance2(it->bp);
                 if( max_distance2 < distance2 ) max_distance2 = distance2;
             }
             m_radius = std::sqrt(max_distance2); // 重心と各点の距離の最大値が半径となる
 
+            // 頂点を囲む矩形を計算する
+            m_box = BoundingBox(m_edges.front().bp, 0.0);
+            for( it = m_edges.begin(); it != m_edges.end(); ++it ) m_box.merge(BoundingBox(it->bp, 0.0));
+
             dc_log("Polygon: 重心:[%g,%g]; 半径:%g",
                    m_center.get_x(), m_center.get_y(), m_radius);
         }
 
+        /**
+         * @brief 符号付き距離場とその勾配を構築する
+         *
+         *  頂点を囲む矩形を @c margin だけ広げた領域を，間隔 @c cell_size の格子点で覆う．
+         * 中心がこの領域に入った Globule は，頂点数によらず 1 回の補間で衝突判定を行う．
+         */
+        void
+        Polygon::build_distance_grid (const double cell_size,
+                                      const double margin)
+        {
+            BoundingBox region = m_box;
+            Vector<double> gradient;
+            std::size_t i, j;
+
+            dc_return_if_fail(! m_edges.empty());
+            dc_return_if_fail(cell_size > 0.0);
+
+            region.expand(margin);
+            m_distance_grid.reset(region, cell_size, 0.0);
+            m_gradient_grid.reset(region, cell_size, Vector<double>(0.0, 0.0));
+
+            for( j = 0; j < m_distance_grid.get_n_rows(); ++j )
+            {
+                for( i = 0; i < m_distance_grid.get_n_columns(); ++i )
+                {
+                    const double distance = get_signed_distance(m_distance_grid.get_point(i, j), gradient);
+
+                    m_distance_grid.set_value(i, j, distance);
+                    m_gradient_grid.set_value(i, j, gradient);
+                }
+            }
+
+            dc_log("Polygon: 距離場 %lu x %lu (間隔 %g)",
+                   (unsigned long) m_distance_grid.get_n_columns(),
+                   (unsigned long) m_distance_grid.get_n_rows(),
+                   cell_size);
+        }
+
+        /**
+         * @brief 点 @c point から辺までの符号付き距離 (内側が負) を求める
+         *
+         *  @c gradient には距離が増える向きの単位ベクトル (最も近い点から離れる向き．内側では
+         * 最も近い点へ向かう向き) を格納する．
+         */
+        double
+        Polygon::get_signed_distance (const Vector<double>& point,
+                                      Vector<double>&       gradient) const
+        {
+            std::vector<Edge>::const_iterator it, nearest = m_edges.end();
+            Vector<double> nearest_point;
+            double min_distance2 = 0.0;
+            bool inside = true;
+
+            for( it = m_edges.begin(); it != m_edges.end(); ++it )
+            {
+                const Vector<double> d = point - it->bp;
+                double t = Vector<double>::inner_product(it->dir, d);
+
+                if( Vector<double>::inner_product(it->norm, d) > 0.0 ) inside = false;
+
+                if( t < 0.0 )               t = 0.0;
+                else if( t > it->length )   t = it->length;
+
+                const Vector<double> q = it->bp + it->dir * t; // 辺上で最も近い点
+                const double distance2 = point.distance2(q);
+                if( nearest == m_edges.end() || distance2 < min_distance2 )
+                {
+                    min_distance2 = distance2;
+                    nearest_point = q;
+                    nearest = it;
+                }
+            }
+
+            const double distance = std::sqrt(min_distance2);
+
+            if( fiszero(distance) ) gradient = nearest->norm; // 辺の上
+            else                    gradient = (point - nearest_point) / (inside ? -distance : distance);
+
+            return inside ? -distance : distance;
+        }
+
         void
         Polygon::load (const SettingFile& file)
         {
@@ -148,6 +251,17 @@ namespace DropletCollection
             origin.set_y( file.get_double(get_name(), "Y", 0, 65535) );
             load_points(file, "Points", origin);
 
+            // 距離場の解像度はステージ単位で [Field] に書く．指定があればここで一度だけ構築する
+            if( file.has_key("Field", "PolygonGridCellSize") )
+            {
+                const double cell_size = file.get_double("Field", "PolygonGridCellSize", 0.5, 65535);
+                const double margin    = file.has_key("Field", "PolygonGridMargin")
+                                       ? file.get_double("Field", "PolygonGridMargin", 0, 65535)
+                                       : 32.0;
+
+                build_distance_grid(cell_size, margin);
+            }
+
             if( file.has_key(get_name(), "Image") )
             {
                 m_image = file.get_image(get_name(), "Image");
@@ -192,7 +306,8 @@ namespace DropletCollection
         }
 
         void
-        Polygon::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        Polygon::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                       const double                         alpha G_GNUC_UNUSED) const
         {
             if( m_image ) // 画像を表示する
             {
@@ -202,11 +317,11 @@ namespace DropletCollection
 
             if( m_show_outline ) // 輪郭線を表示する
             {
-                std::list<LineSegment>::const_iterator it;
+                std::vector<Edge>::const_iterator it;
 
                 cr->set_source_rgb(0.0, 0.0, 0.0);
 
-                for( it = m_segm_list.begin(); it != m_segm_list.end(); ++it )
+                for( it = m_edges.begin(); it != m_edges.end(); ++it )
                 {
                     cr->move_to(it->bp.get_x(), it->bp.get_y());
                     cr->line_to(it->ep.get_x(), it->ep.get_y());
@@ -221,68 +336,216 @@ namespace DropletCollection
             }
         }
 
+        /**
+         * @brief 頂点を囲む矩形を取得する
+         */
         bool
-        Polygon::collide_with_globule (const Polygon& self,
-                                       Globule&       other)
+        Polygon::get_bounding_box (BoundingBox& box) const
         {
-            Vector<double> orien = self.m_center - other.get_position();
+            box = m_box;
+            return true;
+        }
 
-            if( fle(orien.get_size(), self.m_radius + other.get_radius()) ) // バウンディングボリュームとの衝突判定
+        /**
+         * @brief 移動する円 @c other が，最初に接触する辺の時刻を求める
+         *
+         *  各辺について，外側から辺を含む直線に達する時刻を求め，そのときの接触点が辺の中に
+         * 収まっているものを選ぶ．頂点の付近では detect_edge() と同じく接触しない．
+         */
+        bool
+        Polygon::sweep (const Globule&        other,
+                        const Vector<double>& start,
+                        const Vector<double>& motion,
+                        double&               toi) const
+        {
+            const Vector<double> end = start + motion;
+            const double radius = other.get_radius();
+            std::vector<Edge>::const_iterator it;
+            bool hit = false;
+            double t;
+
+            if( m_edges.empty() ) return false;
+
+            // 移動の範囲を囲む矩形との衝突判定
+            BoundingBox box(start, radius);
+            box.merge(BoundingBox(end, radius));
+            if( ! box.expand(OC_FMIN).intersects(m_box) ) return false;
+
+            toi = 1.0;
+            for( it = m_edges.begin(); it != m_edges.end(); ++it )
             {
-                std::list<LineSegment>::const_iterator it;
-                double h;
+                if( ! sweep_gap(Vector<double>::inner_product(it->norm, start - it->bp) - radius,
+                                Vector<double>::inner_product(it->norm, end - it->bp) - radius,
+                                t) ) continue;
+                if( t >= toi && hit ) continue;
 
-                for( it = self.m_segm_list.begin(); it != self.m_segm_list.end(); ++it )
-                {
-                    h = Vector<double>::exterior_product(orien, it->bp - other.get_position())
-                      / Vector<double>::exterior_product(orien, it->bp - it->ep);
-                    if( fbetweq(h, 0.0, 1.0) )
-                    {
-                        if( self.collide_with_line_segment(other, *it) )
-                        {
-                            return true;
-                        }
-                    }
-                }
+                const double s = Vector<double>::inner_product(it->dir, start + motion * t - it->bp); // 接触点の辺上の位置
+                if( ! fle(s * (s - it->length), 0.0) ) continue;
+
+                toi = t;
+                hit = true;
             }
 
-            return false;
+            return hit;
+        }
+
+        /**
+         * @brief 多角形と Globule の衝突に応答する (接触は detect_globule() で検出する)
+         */
+        bool
+        Polygon::collide_with_globule (const Polygon&  self,
+                                       Globule&        other,
+                                       const Manifold& manifold)
+        {
+            self.reflect(other, manifold.normal, manifold.distance, manifold.feature);
+            return true;
         }
 
+        /**
+         * @brief 多角形と Globule の接触を検出する
+         *
+         *  矩形，バウンディングボリュームの順に大まかに判定した後，分離軸定理で判定する．
+         * 凸多角形なので，円の中心からの符号付き距離が最大となる辺 (最も近い辺) の法線だけを
+         * 調べればよく，辺を 1 度走査するだけで済む (除算は行わない)．
+         */
         bool
-        Polygon::collide_with_line_segment (Globule&           other,
-                                            const LineSegment& segm) const
+        Polygon::detect_globule (const Polygon& self,
+                                 const Globule& other,
+                                 Manifold&      manifold)
         {
-            Vector<double> dcp = other.get_position().vector_to_line(segm.bp - segm.ep, segm.bp);
-            Vector<double> cp = dcp + other.get_position(); // 衝突点の位置ベクトル
-            Vector<double> vb = cp - segm.bp, ve = cp - segm.ep;
+            const Vector<double> position = other.get_position();
+            const double radius = other.get_radius();
+            BoundingBox box(position, radius);
 
-            // 衝突点が辺の中に収まっている場合
-            if( fle(Vector<double>::inner_product(vb, ve), 0.0) )
+            if( self.m_edges.empty() ) return false;
+
+            // 矩形との衝突判定
+            if( ! box.expand(OC_FMIN).intersects(self.m_box) ) return false;
+
+            // 距離場の内側なら，辺を調べずに判定する
+            if( self.m_distance_grid.contains(position) ) return self.detect_grid(other, manifold);
+
+            // バウンディングボリュームとの衝突判定
+            if( ! fle(position.distance(self.m_center), self.m_radius + radius) ) return false;
+
+            // 直前の tick に接触していた辺を先に調べる．中心がその辺の外側にあり，辺の範囲に
+            // 射影されるなら，凸多角形ではその辺が最も近い辺なので，他の辺を走査しなくてよい
+            ContactSet::Contact contact;
+            if( self.get_contact(other, contact) &&
+                contact.feature >= 0 && static_cast<std::size_t>(contact.feature) < self.m_edges.size() )
             {
-                double distance = other.get_radius() - dcp.get_size();
-                if( fge(distance, 0.0) ) // 衝突の条件を満たした
+                const Edge& edge = self.m_edges[contact.feature];
+                const double distance = Vector<double>::inner_product(edge.norm, position - edge.bp);
+                const double t = Vector<double>::inner_product(edge.dir, position - edge.bp);
+
+                if( distance > 0.0 && t >= 0.0 && t <= edge.length )
                 {
-                    if( ! is_collided(other) )
-                    {
-                        Vector<double> norm = dcp.get_unit();
-                        Vector<double> v = norm.nob_decompose(other.get_velocity());
-                        v.set_x(-other.get_restitution() * v.get_x());
-                        other.set_velocity(norm.nob_compose(v));
-                    }
-                    else if( ! other.is("Ball") )
-                    {
-                        Vector<double> norm = dcp.get_unit();
-                        Vector<double> v;
-                        v.set_x(-other.get_restitution() * distance);
-                        other.set_velocity(norm.nob_compose(v) + other.get_velocity());
-                    }
-
-                    return true;
+                    if( ! fge(radius - distance, 0.0) ) return false; // 分離軸が存在する
+
+                    return self.detect_edge(other, edge, distance, manifold);
                 }
             }
 
-            return false;
+            // 円の中心から最も近い辺を探す
+            std::vector<Edge>::const_iterator it, nearest = self.m_edges.begin();
+            double distance, max_distance = Vector<double>::inner_product(nearest->norm, position - nearest->bp);
+
+            for( it = nearest + 1; it != self.m_edges.end(); ++it )
+            {
+                distance = Vector<double>::inner_product(it->norm, position - it->bp);
+                if( distance > max_distance )
+                {
+                    max_distance = distance;
+                    nearest = it;
+                }
+            }
+
+            if( ! fge(radius - max_distance, 0.0) ) return false; // 分離軸が存在する
+
+            return self.detect_edge(other, *nearest, max_distance, manifold);
+        }
+
+        /**
+         * @brief 辺 @c edge との接触を検出する
+         *
+         *  @c distance は円の中心から辺までの符号付き距離 (多角形の外側が正) である．
+         */
+        bool
+        Polygon::detect_edge (const Globule& other,
+                              const Edge&    edge,
+                              const double   distance,
+                              Manifold&      manifold) const
+        {
+            const double t = Vector<double>::inner_product(edge.dir, other.get_position() - edge.bp); // 衝突点の辺上の位置
+
+            // 衝突点が辺の中に収まっていない (頂点の付近では衝突しない)
+            if( ! fle(t * (t - edge.length), 0.0) ) return false;
+
+            const double depth = other.get_radius() - std::fabs(distance);
+            if( ! fge(depth, 0.0) ) return false; // 中心が多角形の奥深くにある
+
+            manifold.normal   = distance < 0.0 ? edge.norm : -edge.norm;
+            manifold.distance = depth;
+            manifold.feature  = static_cast<int>(&edge - &m_edges[0]);
+            return true;
+        }
+
+        /**
+         * @brief 距離場を使って接触を検出する
+         *
+         *  法線は距離場の勾配から求めるので，頂点の付近でも (角を丸めた形として) 接触する．
+         */
+        bool
+        Polygon::detect_grid (const Globule& other,
+                              Manifold&      manifold) const
+        {
+            const Vector<double> position = other.get_position();
+            const double distance = m_distance_grid.sample(position);
+            const double depth = other.get_radius() - std::fabs(distance);
+
+            if( ! fge(depth, 0.0) ) return false;
+
+            Vector<double> gradient = m_gradient_grid.sample(position);
+            if( gradient.is_zero() ) return false; // 勾配が打ち消し合っている (内部の稜線上)
+            gradient.set_unit();
+
+            manifold.normal   = distance < 0.0 ? gradient : -gradient;
+            manifold.distance = depth;
+            manifold.feature  = -1;
+            return true;
+        }
+
+        /**
+         * @brief 衝突した Globule を反射させる
+         *
+         *  @c norm は円の中心から衝突点へ向かう単位ベクトル，@c depth はめり込みの深さ，
+         * @c feature は接触した辺の番号 (辺によらない場合は -1) である．
+         */
+        void
+        Polygon::reflect (Globule&              other,
+                          const Vector<double>& norm,
+                          const double          depth,
+                          const int             feature) const
+        {
+            static const ClassId ball_class = intern_class("Ball");
+
+            record_contact(other, -norm, depth, feature);
+
+            if( ! is_collided(other) )
+            {
+                Vector<double> v = norm.nob_decompose(other.get_velocity());
+                v.set_x(-other.get_restitution() * v.get_x());
+                other.set_velocity(norm.nob_compose(v));
+            }
+            else if( ! other.is(ball_class) )
+            {
+                // 接触している間は毎 tick 加速させるので，加算量は時間刻みに比例させる
+                // (基準の時間刻みでは 1 tick あたり depth * 反発係数 の速度になる)
+                const double ref = get_reference_time_step();
+                Vector<double> v;
+                v.set_x(-other.get_restitution() * depth * get_manager().get_time_step() / (ref * ref));
+                other.set_velocity(norm.nob_compose(v) + other.get_velocity());
+            }
         }
     }
 }
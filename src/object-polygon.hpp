@@ -23,8 +23,11 @@
 #endif
 
 #include <list>
+#include <vector>
 #include <gdkmm/pixbuf.h>
+#include "boundingbox.hpp"
 #include "object-objectbase.hpp"
+#include "samplegrid.hpp"
 #include "vector.hpp"
 
 namespace DropletCollection
@@ -47,32 +50,60 @@ namespace DropletCollection
                 inline void                      set_image            (const Glib::RefPtr<Gdk::Pixbuf>& image);
                 bool                             set_points           (const std::list<Vector<double> >& points,
                                                                        const Vector<double>              origin);
+                void                             build_distance_grid  (double                            cell_size,
+                                                                       double                            margin);
                 virtual void                     load                 (const SettingFile& file);
-                virtual void                     draw                 (const Cairo::RefPtr<Cairo::Context>& cr) const;
-                static bool                      collide_with_globule (const Polygon& self,
-                                                                       Globule&       other);
+                virtual void                     draw                 (const Cairo::RefPtr<Cairo::Context>& cr,
+                                                                       double                               alpha) const;
+                virtual bool                     get_bounding_box     (BoundingBox& box) const;
+                virtual bool                     sweep                (const Globule&        other,
+                                                                       const Vector<double>& start,
+                                                                       const Vector<double>& motion,
+                                                                       double&               toi) const;
+                static bool                      collide_with_globule (const Polygon&  self,
+                                                                       Globule&        other,
+                                                                       const Manifold& manifold);
 
             private:
-                struct LineSegment
+                // 辺 (衝突判定に必要な値は set_points() で計算しておく)
+                struct Edge
                 {
-                    Vector<double> bp;
-                    Vector<double> ep;
-                    Vector<double> norm;
+                    Vector<double> bp;     //< 始点
+                    Vector<double> ep;     //< 終点
+                    Vector<double> norm;   //< 外向きの単位法線ベクトル
+                    Vector<double> dir;    //< 始点から終点へ向かう単位ベクトル
+                    double         length; //< 長さ
                 };
 
-                void calc_bounding_volume      ();
-                void load_points               (const SettingFile&    file,
-                                                const Glib::ustring&  key,
-                                                const Vector<double>& origin);
-                bool collide_with_line_segment (Globule&           other,
-                                                const LineSegment& segm) const;
+                void   calc_bounding_volume ();
+                void   load_points          (const SettingFile&    file,
+                                             const Glib::ustring&  key,
+                                             const Vector<double>& origin);
+                static bool detect_globule  (const Polygon&        self,
+                                             const Globule&        other,
+                                             Manifold&             manifold);
+                bool   detect_edge          (const Globule&        other,
+                                             const Edge&           edge,
+                                             double                distance,
+                                             Manifold&             manifold) const;
+                bool   detect_grid          (const Globule&        other,
+                                             Manifold&             manifold) const;
+                void   reflect              (Globule&              other,
+                                             const Vector<double>& norm,
+                                             double                depth,
+                                             int                   feature) const;
+                double get_signed_distance  (const Vector<double>& point,
+                                             Vector<double>&       gradient) const;
 
-                std::list<LineSegment>    m_segm_list;
-                Vector<double>            m_position; //< 座標原点・画像の表示位置
-                Vector<double>            m_center; //< 重心座標
-                double                    m_radius; //< バウンディングボリュームの半径
-                bool                      m_show_outline;
-                Glib::RefPtr<Gdk::Pixbuf> m_image;
+                std::vector<Edge>           m_edges;
+                Vector<double>              m_position; //< 座標原点・画像の表示位置
+                Vector<double>              m_center; //< 重心座標
+                double                      m_radius; //< バウンディングボリュームの半径
+                BoundingBox                 m_box; //< 頂点を囲む矩形
+                SampleGrid<double>          m_distance_grid; //< 符号付き距離場 (内側が負)
+                SampleGrid<Vector<double> > m_gradient_grid; //< 距離場の勾配 (外向きの単位ベクトル)
+                bool                        m_show_outline;
+                Glib::RefPtr<Gdk::Pixbuf>   m_image;
         };
 
         inline bool
@@ -85,15 +85,47 @@ namespace DropletCollection
         }
 
         void
-        Racket::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        Racket::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                      const double                         alpha G_GNUC_UNUSED) const
         {
             dc_return_if_fail(m_image != 0);
             dc_return_if_fail(cr != 0);
 
+            // ラケットは tick によらずポインタに合わせて動くので，補間せずに最新の位置に描く
             Gdk::Cairo::set_source_pixbuf(cr, m_image, m_x - m_width, m_y);
             cr->paint();
         }
 
+        /**
+         * @brief 矩形 @c box と，ラケットの高さの直線との隙間を求める
+         *
+         *  ラケットに当たるかどうかは高さだけで判定し始める (collide_with_ball()) ので，
+         * ラケットの横の位置にはよらない．
+         */
+        bool
+        Racket::get_clearance (const BoundingBox& box,
+                               double&            clearance) const
+        {
+            clearance = m_y - box.bottom;
+            return true;
+        }
+
+        /**
+         * @brief 移動する円 @c other が，ラケットの高さの直線に達する時刻を求める
+         *
+         *  ラケットに当たるか外れるかは，達した時点の位置で collide_with_ball() が判定する．
+         */
+        bool
+        Racket::sweep (const Globule&        other,
+                       const Vector<double>& start,
+                       const Vector<double>& motion,
+                       double&               toi) const
+        {
+            return sweep_gap(m_y - start.get_y() - other.get_radius(),
+                             m_y - (start + motion).get_y() - other.get_radius(),
+                             toi);
+        }
+
         bool
         Racket::collide_with_ball (Racket& self,
                                    Ball&   other)
@@ -102,6 +134,8 @@ namespace DropletCollection
 
             if( self.m_y - p.get_y() < other.get_radius() )
             {
+                self.record_contact(other, Vector<double>(0.0, -1.0), other.get_radius() - (self.m_y - p.get_y()));
+
                 if( !self.is_collided(other) )
                 {
                     double distance = self.m_x - p.get_x();
@@ -44,7 +44,14 @@ namespace DropletCollection
                                                  double x_max,
                                                  double y);
                 virtual void  load              (const SettingFile& file);
-                virtual void  draw              (const Cairo::RefPtr<Cairo::Context>& cr) const;
+                virtual void  draw              (const Cairo::RefPtr<Cairo::Context>& cr,
+                                                 double                               alpha) const;
+                virtual bool  get_clearance     (const BoundingBox& box,
+                                                 double&            clearance) const;
+                virtual bool  sweep             (const Globule&        other,
+                                                 const Vector<double>& start,
+                                                 const Vector<double>& motion,
+                                                 double&               toi) const;
                 static bool   collide_with_ball (Racket& self,
                                                  Ball&   other);
 
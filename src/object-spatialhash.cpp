@@ -0,0 +1,140 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include "error.hpp"
+#include "object-spatialhash.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        SpatialHash::SpatialHash ()
+            : m_left(0.0),
+              m_top(0.0),
+              m_cell_size(1.0),
+              m_n_columns(1),
+              m_n_rows(1),
+              m_cells(1)
+        {
+        }
+
+        /**
+         * @brief 登録されている物体を全て除去し，格子を張り直す
+         *
+         * @param region    格子で覆う領域
+         * @param cell_size セルの一辺の長さ (登録する矩形の最大辺長以上にすること)
+         */
+        void
+        SpatialHash::reset (const BoundingBox& region,
+                            const double       cell_size)
+        {
+            dc_return_if_fail(region.get_width() >= 0.0 && region.get_height() >= 0.0);
+
+            m_left      = region.left;
+            m_top       = region.top;
+            m_cell_size = (cell_size > 1.0) ? cell_size : 1.0;
+            m_n_columns = static_cast<std::size_t>(std::ceil(region.get_width() / m_cell_size));
+            m_n_rows    = static_cast<std::size_t>(std::ceil(region.get_height() / m_cell_size));
+            if( m_n_columns == 0 ) m_n_columns = 1;
+            if( m_n_rows == 0 )    m_n_rows = 1;
+
+            // 各セルの領域は再利用する (毎 tick のメモリ確保を避けるため)
+            if( m_cells.size() < m_n_columns * m_n_rows ) m_cells.resize(m_n_columns * m_n_rows);
+            for( std::size_t i = 0; i < m_cells.size(); ++i ) m_cells[i].clear();
+            m_unbounded.clear();
+        }
+
+        void
+        SpatialHash::insert (const std::size_t  index,
+                             const BoundingBox& box)
+        {
+            const std::size_t c0 = get_column(box.left), c1 = get_column(box.right);
+            const std::size_t r0 = get_row(box.top),     r1 = get_row(box.bottom);
+
+            for( std::size_t r = r0; r <= r1; ++r )
+                for( std::size_t c = c0; c <= c1; ++c )
+                    m_cells[r * m_n_columns + c].push_back(index);
+        }
+
+        /**
+         * @brief 矩形を持たない物体を登録する (全ての問い合わせに対して候補となる)
+         */
+        void
+        SpatialHash::insert (const std::size_t index)
+        {
+            m_unbounded.push_back(index);
+        }
+
+        /**
+         * @brief insert() で矩形 @c box とともに登録した物体 @c index を除去する
+         *
+         *  セルの中の順序は保たない．
+         */
+        void
+        SpatialHash::remove (const std::size_t  index,
+                             const BoundingBox& box)
+        {
+            const std::size_t c0 = get_column(box.left), c1 = get_column(box.right);
+            const std::size_t r0 = get_row(box.top),     r1 = get_row(box.bottom);
+
+            for( std::size_t r = r0; r <= r1; ++r )
+            {
+                for( std::size_t c = c0; c <= c1; ++c )
+                {
+                    std::vector<std::size_t>& cell = m_cells[r * m_n_columns + c];
+                    std::vector<std::size_t>::iterator it = std::find(cell.begin(), cell.end(), index);
+
+                    if( it == cell.end() ) continue;
+
+                    *it = cell.back();
+                    cell.pop_back();
+                }
+            }
+        }
+
+        /**
+         * @brief 矩形 @c box と同じセルに登録されている物体の番号を @c result に追加する
+         *
+         *  同じ物体が複数回追加されることがある．また，矩形同士が実際に重なっているかどうかは
+         * 判定しない．
+         */
+        void
+        SpatialHash::query (const BoundingBox&        box,
+                            std::vector<std::size_t>& result) const
+        {
+            const std::size_t c0 = get_column(box.left), c1 = get_column(box.right);
+            const std::size_t r0 = get_row(box.top),     r1 = get_row(box.bottom);
+
+            for( std::size_t r = r0; r <= r1; ++r )
+            {
+                for( std::size_t c = c0; c <= c1; ++c )
+                {
+                    const std::vector<std::size_t>& cell = m_cells[r * m_n_columns + c];
+                    result.insert(result.end(), cell.begin(), cell.end());
+                }
+            }
+
+            result.insert(result.end(), m_unbounded.begin(), m_unbounded.end());
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_3D2DEF8E_0906_4C09_821A_1F60CA52A4EA
+#define INCLUDE_GUARD_3D2DEF8E_0906_4C09_821A_1F60CA52A4EA
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <vector>
+#include "boundingbox.hpp"
+
+namespace DropletCollection
+{
+    namespace Object
+    {
+        /**
+         * @brief movable 物体同士の衝突候補を絞り込むための一様格子
+         *
+         *  格子は領域 (Field) 全体を覆い，セルの大きさは登録される矩形の最大辺長以上とする．
+         * そのため，各矩形は高々 4 つのセルにしか登録されない．領域外の矩形は最も近い端のセルへ
+         * 登録される．
+         */
+        class SpatialHash
+        {
+            public:
+                SpatialHash ();
+
+                void reset  (const BoundingBox& region,
+                             double             cell_size);
+                void insert (std::size_t        index,
+                             const BoundingBox& box);
+                void insert (std::size_t        index);
+                void remove (std::size_t        index,
+                             const BoundingBox& box);
+                void query  (const BoundingBox&        box,
+                             std::vector<std::size_t>& result) const;
+
+            private:
+                inline std::size_t get_column (double x) const;
+                inline std::size_t get_row    (double y) const;
+
+                double                                m_left;
+                double                                m_top;
+                double                                m_cell_size;
+                std::size_t                           m_n_columns;
+                std::size_t                           m_n_rows;
+                std::vector<std::vector<std::size_t> > m_cells;
+                std::vector<std::size_t>              m_unbounded; //< 矩形を持たない物体 (常に候補とする)
+        };
+
+        inline std::size_t
+        SpatialHash::get_column (const double x) const
+        {
+            if( x <= m_left ) return 0;
+
+            const std::size_t i = static_cast<std::size_t>((x - m_left) / m_cell_size);
+            return (i < m_n_columns) ? i : m_n_columns - 1;
+        }
+
+        inline std::size_t
+        SpatialHash::get_row (const double y) const
+        {
+            if( y <= m_top ) return 0;
+
+            const std::size_t i = static_cast<std::size_t>((y - m_top) / m_cell_size);
+            return (i < m_n_rows) ? i : m_n_rows - 1;
+        }
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_3D2DEF8E_0906_4C09_821A_1F60CA52A4EA */
@@ -31,12 +31,16 @@ namespace DropletCollection
             : Droplet(manager),
               m_collided(false)
         {
+            set_spawner(true); // Ball と衝突すると部品を追加する
+
             if( register_class("Splitter") )
             {
                 register_function("Ball",
-                                  (CollideFunc) &Splitter::collide_with_ball);
+                                  (DetectFunc) &Circle::detect_circle,
+                                  (RespondFunc) &Splitter::collide_with_ball);
                 register_function("Droplet",
-                                  (CollideFunc) &Splitter::collide_with_droplet);
+                                  (DetectFunc) &Circle::detect_circle,
+                                  (RespondFunc) &Splitter::collide_with_droplet);
             }
         }
 
@@ -111,7 +115,7 @@ namespace DropletCollection
             {
                 dc_log("物体 '%s'('Droplet') を 'Splitter' の部品として構築します", it->c_str());
 
-                Droplet *dp = new Droplet (get_manager());
+                Droplet *dp = new (get_manager()) Droplet (get_manager());
                 dp->set_name(*it); // オブジェクト名を設定する
                 dp->load(file); // データを読み込む
 
@@ -120,68 +124,78 @@ namespace DropletCollection
         }
 
         void
-        Splitter::draw (const Cairo::RefPtr<Cairo::Context>& cr) const
+        Splitter::draw (const Cairo::RefPtr<Cairo::Context>& cr,
+                        const double                         alpha) const
         {
             std::list<Segment>::const_iterator it;
 
-            Droplet::draw(cr);
+            Droplet::draw(cr, alpha);
 
             if( m_collided == false ) // 他の Droplet と合成していない場合にのみ，Splitter は機能する
             {
                 for( it = m_segm_list.begin(); it != m_segm_list.end(); ++it )
                 {
-                    it->droplet->set_position(get_position() + it->rel_pos); // 相対座標で位置合わせ
-                    it->droplet->draw(cr);
+                    // 相対座標で位置合わせ (部品は前の tick の状態を持たないので，そのまま描く)
+                    it->droplet->set_position(get_draw_position(alpha) + it->rel_pos);
+                    it->droplet->draw(cr, alpha);
                 }
             }
         }
 
+        /**
+         * @brief Splitter と Ball の衝突に応答する (接触は Circle::detect_circle() で検出する)
+         */
         bool
-        Splitter::collide_with_ball (Splitter& self,
-                                     Ball&     other)
+        Splitter::collide_with_ball (Splitter&       self,
+                                     Ball&           other,
+                                     const Manifold& manifold)
         {
             if( self.m_collided == false ) // Splitter としての効果を持っている
             {
-                if( fge(self.get_distance(other), 0.0) )
-                {
-                    Vector<double> norm, va, vb;
-
-                    // ボールは壁面弾性衝突で跳ね返す
-                    decompose_velocity(self, other, norm, va, vb);
-                    vb.set_x(-vb.get_x());
-                    other.set_velocity(norm.nob_compose(vb));
-
-                    // 部品を配置する
-                    std::list<Segment>::iterator it;
-                    for( it = self.m_segm_list.begin(); it != self.m_segm_list.end(); ++it )
-                    {
-                        it->droplet->set_position(self.get_position() + it->rel_pos); // 相対座標で位置合わせ
-                        self.get_manager().attach(*(it->droplet)); // droplet のコピーを追加する
-                    }
+                const Vector<double>& norm = manifold.normal;
+                Vector<double> va, vb;
 
-                    self.set_alive(false); // self を破棄する
+                // ボールは壁面弾性衝突で跳ね返す
+                decompose_velocity(self, other, norm, va, vb);
+                vb.set_x(-vb.get_x());
+                other.set_velocity(norm.nob_compose(vb));
 
-                    return true;
+                // 部品を配置する
+                std::list<Segment>::iterator it;
+                for( it = self.m_segm_list.begin(); it != self.m_segm_list.end(); ++it )
+                {
+                    it->droplet->set_position(self.get_position() + it->rel_pos); // 相対座標で位置合わせ
+                    self.get_manager().attach(*(it->droplet)); // droplet のコピーを追加する
                 }
 
-                return false;
+                self.set_alive(false); // self を破棄する
+
+                return true;
             }
-            else
+            else // Ball の規則に従う (法線は Ball へ向かう向きに直す)
             {
-                return Ball::collide_with_globule(other, self);
+                Manifold reversed = manifold;
+                reversed.normal = -manifold.normal;
+
+                return Ball::collide_with_globule(other, self, reversed);
             }
         }
 
+        /**
+         * @brief Splitter と Droplet の衝突に応答する (接触は Circle::detect_circle() で検出する)
+         */
         bool
-        Splitter::collide_with_droplet (Splitter& self,
-                                        Droplet&  other)
+        Splitter::collide_with_droplet (Splitter&       self,
+                                        Droplet&        other,
+                                        const Manifold& manifold)
         {
-            bool collided = Droplet::collide_with_droplet(self, other);
+            bool collided = Droplet::collide_with_droplet(self, other, manifold);
 
             // Splitter は他の Droplet と合成するとその効果を失う
             if( collided == true && self.get_group_id() == other.get_group_id() )
             {
                 self.m_collided = true;
+                self.set_spawner(false);
             }
 
             return collided;
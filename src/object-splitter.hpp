@@ -41,11 +41,14 @@ namespace DropletCollection
                 void         add                  (Droplet * object);
                 void         clear                ();
                 virtual void load                 (const SettingFile& file);
-                virtual void draw                 (const Cairo::RefPtr<Cairo::Context>& cr) const;
-                static bool  collide_with_ball    (Splitter& self,
-                                                   Ball&     other);
-                static bool  collide_with_droplet (Splitter& self,
-                                                   Droplet&  other);
+                virtual void draw                 (const Cairo::RefPtr<Cairo::Context>& cr,
+                                                   double                               alpha) const;
+                static bool  collide_with_ball    (Splitter&       self,
+                                                   Ball&           other,
+                                                   const Manifold& manifold);
+                static bool  collide_with_droplet (Splitter&       self,
+                                                   Droplet&        other,
+                                                   const Manifold& manifold);
 
             private:
                 struct Segment
@@ -0,0 +1,246 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_5E0C7B42_93A1_4D6F_B8E2_71C4A9D35F18
+#define INCLUDE_GUARD_5E0C7B42_93A1_4D6F_B8E2_71C4A9D35F18
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "boundingbox.hpp"
+#include "vector.hpp"
+
+namespace DropletCollection
+{
+    /**
+     * @brief 矩形領域上の格子点に値を持ち，任意の点の値を双線形補間で求める格子
+     *
+     *  格子点は領域の左上から @c cell_size 間隔で並び，領域の右端・下端を覆うように取る．
+     * @c ValueT は加算とスカラー倍ができる型 (double や Vector<double>) とする．
+     */
+    template <typename ValueT>
+    class SampleGrid
+    {
+        public:
+            inline SampleGrid ();
+
+            inline void               clear         ();
+            inline bool               empty         () const;
+            inline void               reset         (const BoundingBox& region,
+                                                     double             cell_size,
+                                                     const ValueT&      value);
+            inline const BoundingBox& get_region    () const;
+            inline std::size_t        get_n_columns () const;
+            inline std::size_t        get_n_rows    () const;
+            inline Vector<double>     get_point     (std::size_t column,
+                                                     std::size_t row) const;
+            inline const ValueT&      get_value     (std::size_t column,
+                                                     std::size_t row) const;
+            inline void               set_value     (std::size_t   column,
+                                                     std::size_t   row,
+                                                     const ValueT& value);
+            inline void               add_value     (std::size_t   column,
+                                                     std::size_t   row,
+                                                     const ValueT& value);
+            inline bool               contains      (const Vector<double>& point) const;
+            inline ValueT             sample        (const Vector<double>& point) const;
+
+        private:
+            inline std::size_t locate (double       x,
+                                       double       origin,
+                                       std::size_t  n,
+                                       double&      t) const;
+
+            BoundingBox         m_region; //< 格子点が覆う領域
+            double              m_cell_size;
+            double              m_inv_cell_size;
+            std::size_t         m_n_columns; //< 横方向の格子点の数
+            std::size_t         m_n_rows; //< 縦方向の格子点の数
+            std::vector<ValueT> m_values;
+    };
+
+    template <typename ValueT>
+    inline
+    SampleGrid<ValueT>::SampleGrid ()
+        : m_cell_size(0.0),
+          m_inv_cell_size(0.0),
+          m_n_columns(0),
+          m_n_rows(0)
+    {
+    }
+
+    template <typename ValueT>
+    inline void
+    SampleGrid<ValueT>::clear ()
+    {
+        m_n_columns = m_n_rows = 0;
+        m_values.clear();
+    }
+
+    template <typename ValueT>
+    inline bool
+    SampleGrid<ValueT>::empty () const
+    {
+        return m_values.empty();
+    }
+
+    /**
+     * @brief 領域 @c region を間隔 @c cell_size の格子点で覆い，全ての値を @c value にする
+     */
+    template <typename ValueT>
+    inline void
+    SampleGrid<ValueT>::reset (const BoundingBox& region,
+                               const double       cell_size,
+                               const ValueT&      value)
+    {
+        m_cell_size     = cell_size;
+        m_inv_cell_size = 1.0 / cell_size;
+        m_n_columns     = static_cast<std::size_t>(std::ceil(region.get_width()  * m_inv_cell_size)) + 1;
+        m_n_rows        = static_cast<std::size_t>(std::ceil(region.get_height() * m_inv_cell_size)) + 1;
+        if( m_n_columns < 2 ) m_n_columns = 2;
+        if( m_n_rows    < 2 ) m_n_rows    = 2;
+
+        m_region = BoundingBox(region.left, region.top,
+                               region.left + (m_n_columns - 1) * cell_size,
+                               region.top  + (m_n_rows    - 1) * cell_size);
+        m_values.assign(m_n_columns * m_n_rows, value);
+    }
+
+    template <typename ValueT>
+    inline const BoundingBox&
+    SampleGrid<ValueT>::get_region () const
+    {
+        return m_region;
+    }
+
+    template <typename ValueT>
+    inline std::size_t
+    SampleGrid<ValueT>::get_n_columns () const
+    {
+        return m_n_columns;
+    }
+
+    template <typename ValueT>
+    inline std::size_t
+    SampleGrid<ValueT>::get_n_rows () const
+    {
+        return m_n_rows;
+    }
+
+    /**
+     * @brief 格子点の座標を返す
+     */
+    template <typename ValueT>
+    inline Vector<double>
+    SampleGrid<ValueT>::get_point (const std::size_t column,
+                                   const std::size_t row) const
+    {
+        return Vector<double>(m_region.left + column * m_cell_size,
+                              m_region.top  + row    * m_cell_size);
+    }
+
+    template <typename ValueT>
+    inline const ValueT&
+    SampleGrid<ValueT>::get_value (const std::size_t column,
+                                   const std::size_t row) const
+    {
+        return m_values[row * m_n_columns + column];
+    }
+
+    template <typename ValueT>
+    inline void
+    SampleGrid<ValueT>::set_value (const std::size_t column,
+                                   const std::size_t row,
+                                   const ValueT&     value)
+    {
+        m_values[row * m_n_columns + column] = value;
+    }
+
+    template <typename ValueT>
+    inline void
+    SampleGrid<ValueT>::add_value (const std::size_t column,
+                                   const std::size_t row,
+                                   const ValueT&     value)
+    {
+        m_values[row * m_n_columns + column] += value;
+    }
+
+    /**
+     * @brief 点 @c point が格子の覆う領域に含まれるかどうか
+     */
+    template <typename ValueT>
+    inline bool
+    SampleGrid<ValueT>::contains (const Vector<double>& point) const
+    {
+        return ! empty() &&
+               m_region.left <= point.get_x() && point.get_x() <= m_region.right &&
+               m_region.top  <= point.get_y() && point.get_y() <= m_region.bottom;
+    }
+
+    /**
+     * @brief 点 @c point の値を周囲 4 つの格子点から双線形補間で求める
+     *
+     *  領域外の点は最も近い領域の端の値となる．格子が空であってはならない．
+     */
+    template <typename ValueT>
+    inline ValueT
+    SampleGrid<ValueT>::sample (const Vector<double>& point) const
+    {
+        double tx, ty;
+        const std::size_t i = locate(point.get_x(), m_region.left, m_n_columns, tx);
+        const std::size_t j = locate(point.get_y(), m_region.top,  m_n_rows,    ty);
+        const ValueT *p = &m_values[j * m_n_columns + i];
+
+        return (p[0] * (1.0 - tx) + p[1] * tx) * (1.0 - ty)
+             + (p[m_n_columns] * (1.0 - tx) + p[m_n_columns + 1] * tx) * ty;
+    }
+
+    /**
+     * @brief 座標 @c x を含むセルの番号を返し，セル内の位置 (0 以上 1 以下) を @c t に格納する
+     */
+    template <typename ValueT>
+    inline std::size_t
+    SampleGrid<ValueT>::locate (const double      x,
+                                const double      origin,
+                                const std::size_t n,
+                                double&           t) const
+    {
+        const double f = (x - origin) * m_inv_cell_size;
+
+        if( f <= 0.0 )
+        {
+            t = 0.0;
+            return 0;
+        }
+
+        const std::size_t i = static_cast<std::size_t>(f);
+        if( i >= n - 1 )
+        {
+            t = 1.0;
+            return n - 2;
+        }
+
+        t = f - i;
+        return i;
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_5E0C7B42_93A1_4D6F_B8E2_71C4A9D35F18 */
@@ -0,0 +1,300 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include "error.hpp"
+#include "workerpool.hpp"
+
+namespace DropletCollection
+{
+    // ワーカーが一度に取り出す処理の数
+    const std::size_t WorkerPool::m_chunk_size = 16;
+
+    WorkerPool::Job::~Job ()
+    {
+        // Nothing to do.
+    }
+
+    WorkerPool::WorkerPool ()
+        : m_queues(0),
+          m_job(0),
+          m_n_items(0),
+          m_next_item(0),
+          m_stealing(false),
+          m_generation(0),
+          m_n_busy(0),
+          m_quit(false)
+    {
+    }
+
+    WorkerPool::~WorkerPool ()
+    {
+        stop();
+    }
+
+    /**
+     * @brief ワーカーの数を @c n_workers (呼び出し元のスレッドを含む) にする
+     *
+     *  スレッドを起動できなければ，起動できた数だけで処理を分担する．
+     */
+    void
+    WorkerPool::resize (const unsigned int n_workers)
+    {
+        dc_return_if_fail(n_workers > 0);
+
+        if( n_workers == size() ) return;
+
+        stop();
+        if( n_workers == 1 ) return;
+
+        if( ! Glib::thread_supported() )
+        {
+            dc_warning("スレッドが使えないので，呼び出し元のスレッドだけで処理を行います");
+            return;
+        }
+
+        for( unsigned int i = 1; i < n_workers; ++i )
+        {
+            try
+            {
+                m_threads.push_back(Glib::Thread::create(sigc::bind(sigc::mem_fun(*this, &WorkerPool::work), i), true));
+            }
+            catch(Glib::ThreadError& e)
+            {
+                dc_warning("スレッドを起動できません: %s", e.what().c_str());
+                break;
+            }
+        }
+
+        if( ! m_threads.empty() ) m_queues = new Queue[size()];
+
+        dc_log("WorkerPool: ワーカー %u 個", size());
+    }
+
+    /**
+     * @brief 0 番から @c n_items - 1 番までの処理を分担して実行し，全て終わるまで待つ
+     */
+    void
+    WorkerPool::run (Job&              job,
+                     const std::size_t n_items)
+    {
+        std::size_t i;
+
+        // 分担するほどの量がなければ，呼び出し元のスレッドだけで実行する
+        if( m_threads.empty() || n_items <= m_chunk_size )
+        {
+            for( i = 0; i < n_items; ++i ) job.execute(i, 0);
+            return;
+        }
+
+        start(job, n_items, false);
+    }
+
+    /**
+     * @brief 0 番から @c n_items - 1 番までの処理を，work stealing で分担して実行し，
+     *        全て終わるまで待つ
+     *
+     *  処理は番号の順にワーカーへ 1 つずつ配るので，重い処理から順に番号を付けておくと，
+     * 各ワーカーは重い処理から始め，盗まれるのは軽い処理になる．
+     */
+    void
+    WorkerPool::run_stealing (Job&              job,
+                              const std::size_t n_items)
+    {
+        std::size_t i;
+
+        if( m_threads.empty() || n_items <= 1 )
+        {
+            for( i = 0; i < n_items; ++i ) job.execute(i, 0);
+            return;
+        }
+
+        for( i = 0; i < size(); ++i )
+        {
+            m_queues[i].first = 0;
+            m_queues[i].last  = (n_items + size() - 1 - i) / size();
+        }
+
+        start(job, n_items, true);
+    }
+
+    /**
+     * @brief 処理をワーカーに渡し，呼び出し元のスレッドも分担して，全て終わるまで待つ
+     */
+    void
+    WorkerPool::start (Job&              job,
+                       const std::size_t n_items,
+                       const bool        stealing)
+    {
+        {
+            Glib::Mutex::Lock lock(m_mutex);
+
+            m_job       = &job;
+            m_n_items   = n_items;
+            m_next_item = 0;
+            m_stealing  = stealing;
+            m_n_busy    = m_threads.size();
+            ++m_generation;
+            m_start_cond.broadcast();
+        }
+
+        if( stealing ) steal_items(0);
+        else           run_items(0);
+
+        {
+            Glib::Mutex::Lock lock(m_mutex);
+
+            while( m_n_busy > 0 ) m_done_cond.wait(m_mutex);
+            m_job = 0;
+        }
+    }
+
+    /**
+     * @brief 全てのスレッドを終了させる
+     */
+    void
+    WorkerPool::stop ()
+    {
+        std::size_t i;
+
+        if( m_threads.empty() ) return;
+
+        {
+            Glib::Mutex::Lock lock(m_mutex);
+
+            m_quit = true;
+            m_start_cond.broadcast();
+        }
+
+        for( i = 0; i < m_threads.size(); ++i ) m_threads[i]->join();
+        m_threads.clear();
+        m_quit = false;
+
+        delete [] m_queues;
+        m_queues = 0;
+    }
+
+    /**
+     * @brief ワーカー @c worker のスレッドの本体
+     */
+    void
+    WorkerPool::work (const unsigned int worker)
+    {
+        unsigned long generation = 0;
+        bool stealing;
+
+        for( ;; )
+        {
+            {
+                Glib::Mutex::Lock lock(m_mutex);
+
+                while( ! m_quit && m_generation == generation ) m_start_cond.wait(m_mutex);
+                if( m_quit ) return;
+                generation = m_generation;
+                stealing   = m_stealing;
+            }
+
+            if( stealing ) steal_items(worker);
+            else           run_items(worker);
+
+            {
+                Glib::Mutex::Lock lock(m_mutex);
+
+                if( --m_n_busy == 0 ) m_done_cond.signal();
+            }
+        }
+    }
+
+    /**
+     * @brief 処理を m_chunk_size 個ずつ取り出し，なくなるまで実行する
+     */
+    void
+    WorkerPool::run_items (const unsigned int worker)
+    {
+        std::size_t first, last, i;
+
+        for( ;; )
+        {
+            {
+                Glib::Mutex::Lock lock(m_mutex);
+
+                if( m_next_item >= m_n_items ) return;
+
+                first       = m_next_item;
+                last        = std::min(first + m_chunk_size, m_n_items);
+                m_next_item = last;
+            }
+
+            for( i = first; i < last; ++i ) m_job->execute(i, worker);
+        }
+    }
+
+    /**
+     * @brief 自分の列の先頭から処理を取り出して実行し，列が空になれば他のワーカーの列の
+     *        末尾から盗んで，全ての列が空になるまで続ける
+     */
+    void
+    WorkerPool::steal_items (const unsigned int worker)
+    {
+        const unsigned int n_workers = size();
+        std::size_t item;
+        unsigned int i;
+
+        for( ;; )
+        {
+            if( take_item(worker, false, item) )
+            {
+                m_job->execute(item, worker);
+                continue;
+            }
+
+            // 処理が追加されることはないので，全ての列が空なら終わる
+            for( i = 1; i < n_workers; ++i )
+            {
+                if( take_item((worker + i) % n_workers, true, item) ) break;
+            }
+            if( i == n_workers ) return;
+
+            m_job->execute(item, worker);
+        }
+    }
+
+    /**
+     * @brief 列 @c queue から処理を 1 つ取り出し，その番号を @c item に格納する
+     *
+     *  @c back が false なら先頭から (持ち主)，true なら末尾から (他のワーカー) 取り出す．
+     *
+     * @return 列が空なら false を返す．
+     */
+    bool
+    WorkerPool::take_item (const unsigned int queue,
+                           const bool         back,
+                           std::size_t&       item)
+    {
+        Queue& q = m_queues[queue];
+        Glib::Mutex::Lock lock(q.mutex);
+
+        if( q.first >= q.last ) return false;
+
+        item = (back ? --q.last : q.first++) * size() + queue;
+        return true;
+    }
+}
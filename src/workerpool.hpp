@@ -0,0 +1,119 @@
+/* Droplet Collection - A trifling game.
+ * Copyright (C) 2011  Akinori ABE
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDE_GUARD_247BC39F_1D25_4B15_8CD1_A657952D83E5
+#define INCLUDE_GUARD_247BC39F_1D25_4B15_8CD1_A657952D83E5
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <vector>
+#include <glibmm.h>
+
+namespace DropletCollection
+{
+    /**
+     * @brief 番号で区別される独立な処理を，複数のスレッドで分担して実行する
+     *
+     *  スレッドは resize() で起動したまま待機させておき，run() のたびに処理を渡す．
+     * 呼び出し元のスレッドも処理を分担するので，ワーカーの数が 1 ならスレッドは起動しない．
+     * 処理をどのワーカーが実行するかは実行のたびに変わるので，処理の結果は番号ごとに
+     * 別の場所へ書き込み，ワーカーの割り当てに依存させてはならない．
+     *
+     *  run() は処理を m_chunk_size 個ずつ共通の位置から取り出すので，軽い処理が大量にある
+     * 場合に向く．run_stealing() は処理をワーカーごとの列に分けておき，自分の列が空に
+     * なったワーカーが他の列の末尾から盗む (work stealing) ので，重さの偏った少数の処理に向く．
+     */
+    class WorkerPool
+    {
+        public:
+            // run() に渡す処理
+            class Job
+            {
+                public:
+                    virtual ~Job ();
+
+                    /**
+                     * @brief @c index 番目の処理を，@c worker 番目のワーカー (0 は呼び出し元) で実行する
+                     */
+                    virtual void execute (std::size_t  index,
+                                          unsigned int worker) = 0;
+            };
+
+             WorkerPool ();
+            ~WorkerPool ();
+
+            void                resize       (unsigned int n_workers);
+            inline unsigned int size         () const;
+            void                run          (Job&        job,
+                                              std::size_t n_items);
+            void                run_stealing (Job&        job,
+                                              std::size_t n_items);
+
+        private:
+            WorkerPool (const WorkerPool& other); // Do not call!
+            WorkerPool& operator = (const WorkerPool& other); // Do not call!
+
+            // run_stealing() でワーカーに割り当てた処理の列．位置 p の処理の番号は
+            // p * (ワーカーの数) + (ワーカーの番号) である
+            struct Queue
+            {
+                Glib::Mutex mutex;
+                std::size_t first; //< 持ち主が次に取り出す位置
+                std::size_t last;  //< 他のワーカーが盗む位置の次
+            };
+
+            void start        (Job&        job,
+                               std::size_t n_items,
+                               bool        stealing);
+            void stop         ();
+            void work         (unsigned int worker);
+            void run_items    (unsigned int worker);
+            void steal_items  (unsigned int worker);
+            bool take_item    (unsigned int queue,
+                               bool         back,
+                               std::size_t& item);
+
+            static const std::size_t    m_chunk_size;
+
+            std::vector<Glib::Thread *> m_threads;
+            Glib::Mutex                 m_mutex;
+            Glib::Cond                  m_start_cond; //< 処理が渡されたことをワーカーに知らせる
+            Glib::Cond                  m_done_cond;  //< 全てのワーカーが処理を終えたことを知らせる
+            Queue                     * m_queues;     //< ワーカーごとに 1 つ (run_stealing() で使う)
+            Job                       * m_job;
+            std::size_t                 m_n_items;
+            std::size_t                 m_next_item;  //< まだ取り出されていない最初の処理
+            bool                        m_stealing;   //< run_stealing() の処理を実行している
+            unsigned long               m_generation; //< run() のたびに進む
+            unsigned int                m_n_busy;     //< 処理を終えていないワーカーの数
+            bool                        m_quit;
+    };
+
+    /**
+     * @brief 呼び出し元のスレッドを含むワーカーの数を返す
+     */
+    inline unsigned int
+    WorkerPool::size () const
+    {
+        return m_threads.size() + 1;
+    }
+}
+
+#endif /* ! INCLUDE_GUARD_247BC39F_1D25_4B15_8CD1_A657952D83E5 */